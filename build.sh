@@ -24,7 +24,7 @@ NC='\033[0m'
 CORES=`getconf _NPROCESSORS_ONLN`
 mkdir -p build
 pushd build &> /dev/null
-cmake ../
+cmake ../ "$@"
 #exit
 make -j${CORES}
 popd &> /dev/null
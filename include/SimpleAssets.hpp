@@ -17,6 +17,10 @@
 #include <eosiolib/asset.hpp>
 #include <eosiolib/singleton.hpp>
 #include <eosiolib/transaction.hpp>
+#include <eosiolib/crypto.hpp>
+
+#include <SimpleAssetsInstrument.hpp>
+#include <SimpleAssetsArena.hpp>
 
 using namespace eosio;
 using std::string;
@@ -27,6 +31,10 @@ CONTRACT SimpleAssets : public contract {
 	public:
 		using contract::contract;
 
+		// writes the table size counters changed by the action (see tablestats); with SA_INSTRUMENT
+		// also prints per-action resource counters, see SimpleAssetsInstrument.hpp
+		~SimpleAssets();
+
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 		/*
 		* Update version of this SimpleAstes deployment for 3rd party wallets, marketplaces, etc
@@ -35,6 +43,70 @@ CONTRACT SimpleAssets : public contract {
 		using updatever_action = action_wrapper<"updatever"_n, &SimpleAssets::updatever>;
 
 
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Configures the event log (table `events`), a pull-based alternative to deferred event
+		* transactions. Each saecreate, saetransfer, saeclaim and saeburn event is written to slot
+		* seq % capacity, overwriting the oldest record, so the log never grows beyond capacity rows.
+		*
+		* capacity - number of slots, 0 disables the log. Can not be set below the slots already
+		*            in use (evconfig.allocated), so no stale rows are left behind;
+		* deferred - keep sending deferred event transactions to authors as well. Ignored (always
+		*            sent) while the log is disabled.
+		*/
+		ACTION setevents( uint32_t capacity, bool deferred );
+		using setevents_action = action_wrapper<"setevents"_n, &SimpleAssets::setevents>;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Moves up to `limit` rows from the self scoped offers, offerfs and delegates tables to the
+		* partitioned tables (offersown/offersto, offerfsown/offerfsto, delegatesto). RAM of moved
+		* rows is paid by the contract. Once the old tables are empty, lookups stop falling back
+		* to them. Call repeatedly until spare1 in the global table is 1.
+		*
+		* limit - max rows to move in this call;
+		*/
+		ACTION migrate( uint32_t limit );
+		using migrate_action = action_wrapper<"migrate"_n, &SimpleAssets::migrate>;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Turns on the ownership commitment: a sparse Merkle tree over (assetid, owner) of all assets
+		* in the sassets tables, with its root in the merkle table. Can not be turned off again.
+		* Assets that existed before must be added with merklesync. Node rows are paid by the contract
+		* (about one row per asset).
+		*/
+		ACTION setmerkle();
+		using setmerkle_action = action_wrapper<"setmerkle"_n, &SimpleAssets::setmerkle>;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Writes the current owner of existing assets into the ownership commitment. Used once after
+		* setmerkle for assets created before it. Anyone can call it; it only copies table state.
+		*
+		* owner		- account holding the assets;
+		* assetids	- array of assetid's held by owner;
+		*/
+		ACTION merklesync( name owner, std::vector<uint64_t>& assetids );
+		using merklesync_action = action_wrapper<"merklesync"_n, &SimpleAssets::merklesync>;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Sets a tablestats counter, e.g. to seed it with the size of rows that existed before the
+		* counters were introduced (saindex stats prints them).
+		*
+		* table	- sassets, offers, offerfs or delegates;
+		* rows	- number of rows;
+		* bytes	- approximate RAM of the rows;
+		*/
+		ACTION setstats( name table, int64_t rows, int64_t bytes );
+		using setstats_action = action_wrapper<"setstats"_n, &SimpleAssets::setstats>;
+
+
 		// ===============================================================================================
 		// ============= Non-Fungible Token Actions ======================================================
 		// ===============================================================================================
@@ -92,13 +164,53 @@ CONTRACT SimpleAssets : public contract {
 
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 		/*
-		* Empty action. Used by create action to log assetid so that third party explorers can
-		* easily get new asset ids and other information.
+		* Empty action. Was used by create action to log assetid; no longer sent (see createlogh), kept
+		* so that older history can still be decoded with the current ABI.
 		*/
 		ACTION createlog( name author, name category, name owner, string idata, string mdata, uint64_t assetid, bool requireclaim);
 		using createlog_action = action_wrapper<"createlog"_n, &SimpleAssets::createlog>;
 
 
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Empty action. Used by create action to log assetid so that third party explorers can
+		* easily get new asset ids and other information. idata and mdata are not repeated, they are
+		* in the parent create action; {{datahash}} is sha256 of the two strings as serialized there
+		* (varuint32 length + bytes each).
+		*/
+		ACTION createlogh( name author, name category, name owner, uint64_t assetid, bool requireclaim, checksum256 datahash );
+		using createlogh_action = action_wrapper<"createlogh"_n, &SimpleAssets::createlogh>;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Creates an edition of {{count}} assets with shared data as one drop row, independent of the
+		* edition size. The assets get sequential ids and belong to {{owner}}; the sassets row of an
+		* edition is created (paid by the account acting on it) the first time the asset is
+		* transferred, offered, delegated, burned, attached (to a container or as the container of
+		* attached assets or tokens) or updated. RAM of the drop row (data and one bit per 1024
+		* editions) is paid by the author and released once all editions were created; the bitmap
+		* of created editions of each 1024 ids is paid by whoever creates the first of them. The id range is logged by the droplog inline action.
+		*
+		* author	- asset's author, who will able to updated asset's mdata;
+		* category	- assets category;
+		* owner		- owner of all editions;
+		* idata		- stringified json or just sha256 string with immutable assets data;
+		* mdata		- initial mutable data of every edition;
+		* count		- number of editions;
+		*/
+		ACTION createdrop( name author, name category, name owner, string idata, string mdata, uint64_t count );
+		using createdrop_action = action_wrapper<"createdrop"_n, &SimpleAssets::createdrop>;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Empty action. Used by createdrop to log the ids of the new editions, {{first}} to {{last}}.
+		*/
+		ACTION droplog( name author, name owner, uint64_t first, uint64_t last );
+		using droplog_action = action_wrapper<"droplog"_n, &SimpleAssets::droplog>;
+
+
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 		/*
 		* Claim the specified asset (assuming it was offered to claimer by the asset owner).
@@ -115,6 +227,7 @@ CONTRACT SimpleAssets : public contract {
 		* This actions transfers an asset. On transfer owner asset's and scope asset's changes to {{to}}'s.
 		* Senders RAM will be charged to transfer asset.
 		* Transfer will fail if asset is offered for claim or is delegated.
+		* Can also be signed by an operator approved by {{from}} (see approve) instead of {{from}}.
 		*
 		* from		- account who sends the asset;
 		* to		- account of receiver;
@@ -179,6 +292,50 @@ CONTRACT SimpleAssets : public contract {
 		using burn_action = action_wrapper<"burn"_n, &SimpleAssets::burn>;
 
 
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Transfers all assets of {{from}} (optionally only of one author and/or category) without
+		* listing their ids. Walks {{from}}'s assets starting at id {{cursor}} and looks at up to
+		* {{limit}} of them; assets that are offered for claim or delegated are skipped. The id to
+		* continue from is logged by the bulklog inline action (0 - all assets were looked at).
+		*
+		* from		- account who sends the assets;
+		* to		- account of receiver;
+		* author	- only assets of this author, empty for all;
+		* category	- only assets of this category, empty for all;
+		* cursor	- lowest assetid to look at, 0 to start from the beginning;
+		* limit		- max number of assets to look at in this call;
+		* memo		- transfers comment;
+		*/
+		ACTION transferall( name from, name to, name author, name category, uint64_t cursor, uint32_t limit, string memo );
+		using transferall_action = action_wrapper<"transferall"_n, &SimpleAssets::transferall>;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Burns all assets of {{owner}} (optionally only of one author and/or category), walking them
+		* the same way as transferall.
+		*
+		* owner		- current assets owner account;
+		* author	- only assets of this author, empty for all;
+		* category	- only assets of this category, empty for all;
+		* cursor	- lowest assetid to look at, 0 to start from the beginning;
+		* limit		- max number of assets to look at in this call;
+		* memo		- memo for burn action;
+		*/
+		ACTION burnall( name owner, name author, name category, uint64_t cursor, uint32_t limit, string memo );
+		using burnall_action = action_wrapper<"burnall"_n, &SimpleAssets::burnall>;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Empty action. Used by transferall and burnall to log how many assets were moved or burned
+		* and the cursor for the next call.
+		*/
+		ACTION bulklog( name owner, name type, uint64_t nextcursor, uint32_t count );
+		using bulklog_action = action_wrapper<"bulklog"_n, &SimpleAssets::bulklog>;
+
+
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 		/*
 		* Delegates asset to {{to}}. This action changes the asset owner by calling the transfer action.
@@ -209,6 +366,88 @@ CONTRACT SimpleAssets : public contract {
 		using undelegate_action = action_wrapper<"undelegate"_n, &SimpleAssets::undelegate>;
 
 
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Takes back assets from {{from}} whose delegation period has expired, directly, without the
+		* inline transfer of undelegate. The delegates rows are erased. Expired delegations are also
+		* resolved by any transfer, offer, burn or attach of the borrower touching such an asset: the
+		* asset goes back to its owner and is left out of that action.
+		*
+		* owner		- real asset owner account, pays RAM of the returned assets;
+		* from		- current account owner (borrower);
+		* assetids	- array of assetid's to take back;
+		*/
+		ACTION reclaim( name owner, name from, std::vector<uint64_t>& assetids );
+		using reclaim_action = action_wrapper<"reclaim"_n, &SimpleAssets::reclaim>;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Approves operator {{op}} (e.g. a marketplace) to transfer {{owner}}'s assets of {{author}}, or
+		* all of {{owner}}'s assets if author is empty, by signing transfer itself, without offer and
+		* claim. RAM of the approvals row is paid by the owner.
+		*
+		* owner		- account whose assets the operator may transfer;
+		* op		- operator account;
+		* author	- only assets of this author, empty for all;
+		*/
+		ACTION approve( name owner, name op, name author );
+		using approve_action = action_wrapper<"approve"_n, &SimpleAssets::approve>;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Revokes an approval given with approve.
+		*
+		* owner		- account who gave the approval;
+		* op		- operator account;
+		* author	- author to revoke, empty to revoke the operator completely;
+		*/
+		ACTION revoke( name owner, name op, name author );
+		using revoke_action = action_wrapper<"revoke"_n, &SimpleAssets::revoke>;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Run of sequential asset ids: first, first + 1, ... first + count - 1. Asset ids are given out
+		* sequentially, so batches are mostly a few long runs; 12 bytes per run instead of 8 per id.
+		*/
+		struct idrange {
+			uint64_t	first;
+			uint32_t	count;
+
+			EOSLIB_SERIALIZE( idrange, (first)(count) )
+		};
+
+		/*
+		* Same as transfer, burn, offer, canceloffer, claim, delegate and undelegate, with the assets
+		* given as runs of sequential ids.
+		*
+		* ranges	- array of {first, count} runs, at most 10000 assets in total;
+		*/
+		ACTION transferr( name from, name to, std::vector<idrange>& ranges, string memo );
+		using transferr_action = action_wrapper<"transferr"_n, &SimpleAssets::transferr>;
+
+		ACTION burnr( name owner, std::vector<idrange>& ranges, string memo );
+		using burnr_action = action_wrapper<"burnr"_n, &SimpleAssets::burnr>;
+
+		ACTION offerr( name owner, name newowner, std::vector<idrange>& ranges, string memo );
+		using offerr_action = action_wrapper<"offerr"_n, &SimpleAssets::offerr>;
+
+		ACTION cancelofferr( name owner, std::vector<idrange>& ranges );
+		using cancelofferr_action = action_wrapper<"cancelofferr"_n, &SimpleAssets::cancelofferr>;
+
+		ACTION claimr( name claimer, std::vector<idrange>& ranges );
+		using claimr_action = action_wrapper<"claimr"_n, &SimpleAssets::claimr>;
+
+		ACTION delegater( name owner, name to, std::vector<idrange>& ranges, uint64_t period, string memo );
+		using delegater_action = action_wrapper<"delegater"_n, &SimpleAssets::delegater>;
+
+		// the memo of the inline transfer lists the runs instead of every id
+		ACTION undelegater( name owner, name from, std::vector<idrange>& ranges );
+		using undelegater_action = action_wrapper<"undelegater"_n, &SimpleAssets::undelegater>;
+
+
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 		/*
 		* Attach other NFTs to the specified NFT. Restrictions:
@@ -265,6 +504,33 @@ CONTRACT SimpleAssets : public contract {
 		using detachf_t_action = action_wrapper<"detachf"_n, &SimpleAssets::detachf>;
 
 
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* One attachf / detachf entry.
+		*/
+		struct ftentry {
+			uint64_t	assetidc;
+			name		author;
+			asset		quantity;
+
+			EOSLIB_SERIALIZE( ftentry, (assetidc)(author)(quantity) )
+		};
+
+		/*
+		* Attach / detach FTs of several tokens to / from several NFTs of {{owner}} in one action, with
+		* the same restrictions as attachf and detachf. Each NFT is updated once and each token
+		* balance of the owner changes once by the total of its entries.
+		*
+		* owner		- owner of assets;
+		* entries	- array of {assetidc, author, quantity};
+		*/
+		ACTION attachfs( name owner, std::vector<ftentry>& entries );
+		using attachfs_action = action_wrapper<"attachfs"_n, &SimpleAssets::attachfs>;
+
+		ACTION detachfs( name owner, std::vector<ftentry>& entries );
+		using detachfs_action = action_wrapper<"detachfs"_n, &SimpleAssets::detachfs>;
+
+
 
 		// ===============================================================================================
 		// ============= Fungible Token Actions ==========================================================
@@ -341,6 +607,31 @@ CONTRACT SimpleAssets : public contract {
 		using offerf_action = action_wrapper<"offerf"_n, &SimpleAssets::offerf>;
 
 
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* One offerf offer.
+		*/
+		struct ftoffer {
+			name		newowner;
+			name		author;
+			asset		quantity;
+			string		memo;
+
+			EOSLIB_SERIALIZE( ftoffer, (newowner)(author)(quantity)(memo) )
+		};
+
+		/*
+		* Makes several FT offers in one action, with the same restrictions as offerf. The owner's
+		* open offers are read once, offer ids are reserved with one write and each token balance of
+		* the owner is reduced once by the total of its offers.
+		*
+		* owner  - original owner of the FTs;
+		* offers - array of {newowner, author, quantity, memo};
+		*/
+		ACTION offerfbatch( name owner, std::vector<ftoffer>& offers );
+		using offerfbatch_action = action_wrapper<"offerfbatch"_n, &SimpleAssets::offerfbatch>;
+
+
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 		/*
 		* Cancels offer of FTs
@@ -403,6 +694,68 @@ CONTRACT SimpleAssets : public contract {
 		using closef_action = action_wrapper<"closef"_n, &SimpleAssets::closef>;
 
 
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Turns on sharded balances for an account receiving many FT transfers (exchange deposit
+		* accounts, reward pools). Credits from other accounts then go to one of {{shards}} rows of
+		* the accshards table, chosen by the sender, instead of the single accounts row, so
+		* concurrent transfers to the account do not all modify the same row. Debits use the
+		* accounts row and consolidate the shards into it when it does not cover them.
+		*
+		* owner  - account whose balances are sharded;
+		* shards - number of shard rows per token, 2..16; 0 turns sharding off (existing shard
+		*          rows are still counted until consolidated);
+		*/
+		ACTION setshards( name owner, uint8_t shards );
+		using setshards_action = action_wrapper<"setshards"_n, &SimpleAssets::setshards>;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Moves the shard balances of a token into the owner's accounts row and frees the shard rows.
+		* Anyone can call it, the balance does not change. Needs the owner's authorization only if
+		* the accounts row does not exist yet (its RAM is paid by the owner).
+		*
+		* owner  - account with sharded balances;
+		* author - account of fungible token author;
+		* symbol - token symbol, example "WOOD", "ROCK", "GOLD";
+		*/
+		ACTION consolidate( name owner, name author, const symbol& symbol );
+		using consolidate_action = action_wrapper<"consolidate"_n, &SimpleAssets::consolidate>;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Turns automatic RAM reclamation of zero balances on or off for a token of {{author}} or for
+		* all of the author's tokens. When a debit billed to the author leaves an accounts row at zero
+		* and the owner has no open offer of the token, the row is erased instead of kept until closef.
+		* Rows that are already zero are erased with sweepf.
+		*
+		* author - account of fungible token author;
+		* sym    - token symbol, example "WOOD"; empty for all tokens of the author;
+		* on     - true to turn reclamation on, false to turn it off;
+		*/
+		ACTION setreclaim( name author, symbol_code sym, bool on );
+		using setreclaim_action = action_wrapper<"setreclaim"_n, &SimpleAssets::setreclaim>;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Erases the zero balance rows of a token of {{author}} held by the listed accounts, if
+		* reclamation is on for the token (see setreclaim). Only rows billed to the author or the
+		* contract are erased: accounts that pay for their row, and accounts with a balance, balance
+		* shards or open offers of the token are skipped. RAM goes back to the author (or contract).
+		* `saindex zero` lists the zero balance rows paid by the author or the contract. Only rows
+		* that reached zero while reclamation was on are marked as such and swept.
+		*
+		* author - account of fungible token author;
+		* sym    - token symbol, example "WOOD", "ROCK", "GOLD";
+		* owners - up to 200 accounts to sweep;
+		*/
+		ACTION sweepf( name author, symbol_code sym, std::vector<name>& owners );
+		using sweepf_action = action_wrapper<"sweepf"_n, &SimpleAssets::sweepf>;
+
+
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 		/*
 		* Returns Current token supply.
@@ -420,7 +773,7 @@ CONTRACT SimpleAssets : public contract {
 
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 		/*
-		* Returns token balance for account
+		* Returns token balance for account, including balance shards (see setshards)
 		*
 		* token_contract_account  - contract to check;
 		* owner	                  - token holder account;
@@ -431,9 +784,18 @@ CONTRACT SimpleAssets : public contract {
 			stats statstable( token_contract_account, author.value );
 			const auto& st = statstable.get( sym_code.raw() );
 
+			asset res( 0, st.supply.symbol );
 			accounts accountstable( token_contract_account, owner.value );
-			const auto& ac = accountstable.get( st.id );
-			return ac.balance;
+			auto ac = accountstable.find( st.id );
+			if ( ac != accountstable.end() )
+				res = ac->balance;
+
+			accshards shards( token_contract_account, owner.value );
+			for ( auto s = shards.lower_bound( st.id << 4 ); s != shards.end() && ( s->key >> 4 ) == st.id; ++s )
+				res += s->balance;
+
+			check( ac != accountstable.end() || res.amount > 0, "no balance object found" );
+			return res;
 		}
 
 
@@ -442,17 +804,40 @@ CONTRACT SimpleAssets : public contract {
 	//=============================================================================================================================
 	private:
 
-		uint64_t getid(bool defer);
+		uint64_t getid(bool defer, uint64_t count = 1);
+		static std::vector<uint64_t> expandRanges( const std::vector<idrange>& ranges );
+		void undelegateIds( name owner, name from, std::vector<uint64_t>& assetids, const string& memo );
 		uint64_t getFTIndex(name author, symbol symbol);
 
-		void attachdeatch( name owner, name author, asset quantity, uint64_t assetidc, bool attach );
+		void attachdeatch( name owner, const std::vector<ftentry>& entries, bool attach );
+		void offerFts( name owner, const std::vector<ftoffer>& offers );
 
 		void sub_balancef( name owner, name author, asset value );
-		void add_balancef( name owner, name author, asset value, name ram_payer );
+		void add_balancef( name owner, name author, asset value, name ram_payer, name from = name() );
+		int64_t shardBalance( name owner, uint64_t ftid, bool erase );
+		bool reclaimOn( name author, symbol_code sym );
+		void markZerof( name owner, uint64_t ftid, name payer );
 
 		template<typename... Args>
 		void sendEvent(name author, name rampayer, name seaction, const std::tuple<Args...> &tup);
 
+		void logEvent( name type, name author, name from, name to, const saarena::vector<uint64_t>& assetids );
+		bool deferEvents();
+		void flushEvents();
+
+		void countRows( name table, int64_t rows, int64_t bytes );
+		void flushStats();
+
+		// approximate RAM of a primary table row: serialized size + billable row overhead
+		template<typename T>
+		static int64_t rowBytes( const T& row ) {
+			return int64_t( pack_size( row ) ) + 112;
+		}
+
+		bool merkleOn();
+		void merkleSet( uint64_t assetid, name owner );
+		void merkleCommit();
+
 
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 		/*
@@ -471,7 +856,7 @@ CONTRACT SimpleAssets : public contract {
 
 		};
 
-		typedef eosio::multi_index< "authors"_n, sauthor > authors;
+		typedef sa_table< eosio::multi_index< "authors"_n, sauthor > > authors;
 
 
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
@@ -493,7 +878,7 @@ CONTRACT SimpleAssets : public contract {
 			}
 		};
 
-		typedef eosio::multi_index< "stat"_n, currency_stats > stats;
+		typedef sa_table< eosio::multi_index< "stat"_n, currency_stats > > stats;
 
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 		/*
@@ -510,7 +895,77 @@ CONTRACT SimpleAssets : public contract {
 			}
 		};
 
-		typedef eosio::multi_index< "accounts"_n, account > accounts;
+		typedef sa_table< eosio::multi_index< "accounts"_n, account > > accounts;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Balance shards of accounts with sharded balances (see setshards). The balance of a token is
+		* the accounts row plus all its shards.
+		* key = token id * 16 + shard
+		* Scope: token owner
+		*/
+		TABLE accshard {
+			uint64_t	key;
+			asset		balance;
+
+			uint64_t primary_key()const {
+				return key;
+			}
+		};
+
+		typedef sa_table< eosio::multi_index< "accshards"_n, accshard > > accshards;
+
+
+		/*
+		* Accounts with sharded balances and their number of shards.
+		* Scope: self
+		*/
+		TABLE sftshards {
+			name		owner;
+			uint8_t		shards;
+
+			auto primary_key() const {
+				return owner.value;
+			}
+		};
+
+		typedef sa_table< eosio::multi_index< "ftshards"_n, sftshards > > ftshards;
+
+
+		/*
+		* Tokens whose zero balance rows are erased automatically (see setreclaim), sym 0 - all
+		* tokens of the author.
+		* Scope: token author
+		*/
+		TABLE sreclaimf {
+			symbol_code	sym;
+
+			uint64_t primary_key()const {
+				return sym.raw();
+			}
+		};
+
+		typedef sa_table< eosio::multi_index< "reclaimf"_n, sreclaimf > > reclaimfs;
+
+
+		/*
+		* Zero balance accounts rows billed to the token's author or to the contract, the rows
+		* sweepf may erase (the contract can not read the payer of a row). Set, while reclamation
+		* is on for the token, or removed whenever a row reaches zero; a marker of a row that was
+		* credited since is stale until then. Rows that reached zero before are not marked.
+		* id = token id, paid like the accounts row.
+		* Scope: token owner
+		*/
+		TABLE szerof {
+			uint64_t	id;
+
+			uint64_t primary_key()const {
+				return id;
+			}
+		};
+
+		typedef sa_table< eosio::multi_index< "zerofs"_n, szerof > > zerofs;
 
 
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
@@ -538,9 +993,55 @@ CONTRACT SimpleAssets : public contract {
 
 		};
 
-		typedef eosio::multi_index< "sassets"_n, sasset,
+		typedef sa_table< eosio::multi_index< "sassets"_n, sasset,
 			eosio::indexed_by< "author"_n, eosio::const_mem_fun<sasset, uint64_t, &sasset::by_author> >
-			> sassets;
+			> > sassets;
+
+
+		/*
+		* Editions of a drop not yet in sassets, scope = owner. Keyed by the last id so that
+		* lower_bound( assetid ) finds the drop covering an id. Which editions were created is kept
+		* per chunk of dropchunk ids in dropbits; bit k of done is set once chunk k is complete (its
+		* dropbits row is then erased). The row is erased when left reaches 0.
+		* SimpleAssetsReader.hpp reads the fields up to done directly, keep them in front.
+		*/
+		TABLE sdrop {
+			uint64_t				last;
+			uint64_t				first;
+			name					author;
+			name					category;
+			name					owner;
+			uint64_t				left;
+			std::vector<uint8_t>	done;
+			string					idata;
+			string					mdata;
+
+			auto primary_key() const {
+				return last;
+			}
+		};
+
+		typedef sa_table< eosio::multi_index< "drops"_n, sdrop > > drops;
+
+		static constexpr uint64_t dropchunk = 1024;		// editions per dropbits row
+
+
+		/*
+		* Created editions of one chunk of a drop, scope = owner, key = first id of the chunk
+		* (first + k * dropchunk). Bit i of taken is set once asset base + i was created. Paid by
+		* the account that created the first edition of the chunk, erased when the chunk is complete.
+		*/
+		TABLE sdropbits {
+			uint64_t				base;
+			uint64_t				left;
+			std::vector<uint8_t>	taken;
+
+			auto primary_key() const {
+				return base;
+			}
+		};
+
+		typedef sa_table< eosio::multi_index< "dropbits"_n, sdropbits > > dropbits;
 
 
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
@@ -548,7 +1049,9 @@ CONTRACT SimpleAssets : public contract {
 		* Offers table keeps records of open offers of assets (ie. assets waiting to be claimed by their
 		* intendend recipients.
 		*
-		* Scope: self
+		* offers    - rows created before partitioning. Scope: self
+		* offersown - Scope: owner (account holding the asset)
+		* offersto  - copy of offersown rows for recipient queries, RAM paid twice. Scope: offeredto
 		*/
 		TABLE soffer {
 			uint64_t		assetid;
@@ -567,10 +1070,13 @@ CONTRACT SimpleAssets : public contract {
 			}
 		};
 
-		typedef eosio::multi_index< "offers"_n, soffer,
+		typedef sa_table< eosio::multi_index< "offers"_n, soffer,
 			eosio::indexed_by< "owner"_n, eosio::const_mem_fun<soffer, uint64_t, &soffer::by_owner> >,
 			eosio::indexed_by< "offeredto"_n, eosio::const_mem_fun<soffer, uint64_t, &soffer::by_offeredto> >
-			> offers;
+			> > offers;
+
+		typedef sa_table< eosio::multi_index< "offersown"_n, soffer > > offersown;
+		typedef sa_table< eosio::multi_index< "offersto"_n, soffer > > offersto;
 
 
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
@@ -578,7 +1084,9 @@ CONTRACT SimpleAssets : public contract {
 		* Offers table keeps records of open offers of FT (ie. waiting to be claimed by their
 		* intendend recipients.
 		*
-		* Scope: self
+		* offerfs    - rows created before partitioning. Scope: self
+		* offerfsown - Scope: owner
+		* offerfsto  - copy of offerfsown rows for recipient queries, RAM paid twice. Scope: offeredto
 		*/
 		TABLE sofferf {
 			uint64_t		id;
@@ -599,16 +1107,21 @@ CONTRACT SimpleAssets : public contract {
 			}
 		};
 
-		typedef eosio::multi_index< "offerfs"_n, sofferf,
+		typedef sa_table< eosio::multi_index< "offerfs"_n, sofferf,
 			eosio::indexed_by< "owner"_n, eosio::const_mem_fun<sofferf, uint64_t, &sofferf::by_owner> >,
 			eosio::indexed_by< "offeredto"_n, eosio::const_mem_fun<sofferf, uint64_t, &sofferf::by_offeredto> >
-			> offerfs;
+			> > offerfs;
+
+		typedef sa_table< eosio::multi_index< "offerfsown"_n, sofferf > > offerfsown;
+		typedef sa_table< eosio::multi_index< "offerfsto"_n, sofferf > > offerfsto;
 
 
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 		/*
 		* Delegates table keeps records about borrowed assets.
-		* Scope: self
+		*
+		* delegates   - rows created before partitioning. Scope: self
+		* delegatesto - Scope: delegatedto (account holding the asset)
 		*/
 		TABLE sdelegate {
 			uint64_t		assetid;
@@ -628,15 +1141,35 @@ CONTRACT SimpleAssets : public contract {
 			}
 		};
 
-		typedef eosio::multi_index< "delegates"_n, sdelegate,
+		typedef sa_table< eosio::multi_index< "delegates"_n, sdelegate,
 			eosio::indexed_by< "owner"_n, eosio::const_mem_fun<sdelegate, uint64_t, &sdelegate::by_owner> >,
 			eosio::indexed_by< "delegatedto"_n, eosio::const_mem_fun<sdelegate, uint64_t, &sdelegate::by_delegatedto> >
-		> delegates;
+		> > delegates;
+
+		typedef sa_table< eosio::multi_index< "delegatesto"_n, sdelegate > > delegatesto;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Operators allowed to transfer the owner's assets (see approve).
+		* Scope: owner
+		*/
+		TABLE sapproval {
+			name				op;
+			std::vector<name>	authors;	// empty - assets of all authors
+
+			auto primary_key() const {
+				return op.value;
+			}
+		};
+
+		typedef sa_table< eosio::multi_index< "approvals"_n, sapproval > > approvals;
 
 
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 		/*
 		* global singelton table, used for assetid building
+		* spare1 - 1 when the self scoped offers, offerfs and delegates tables are migrated (empty)
 		* Scope: self
 		*/
 		TABLE global {
@@ -653,6 +1186,113 @@ CONTRACT SimpleAssets : public contract {
 		global _cstate;
 
 
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Event log settings and write position, see setevents.
+		* Scope: self
+		*/
+		TABLE evconfig {
+			uint32_t	capacity	= 0;	// slots, 0 - log disabled
+			uint32_t	allocated	= 0;	// highest slot in use + 1
+			uint64_t	nextseq		= 0;	// sequence number of the next event
+			bool		deferred	= true;	// also send deferred event transactions
+
+			EOSLIB_SERIALIZE( evconfig, (capacity)(allocated)(nextseq)(deferred) )
+		};
+
+		typedef eosio::singleton< "evconfig"_n, evconfig> evconf;
+		evconfig _evstate;
+		bool _evloaded = false;
+		bool _evdirty = false;		// _evstate changed by this action, written from the destructor
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Event log ring buffer. Rows are overwritten in place, oldest first.
+		* Consumers remember the last seq they processed and read on from slot (seq + 1) % capacity.
+		* type - saecreate, saetransfer, saeclaim or saeburn;
+		* from - previous owner (author for saecreate, owner for saeburn);
+		* to   - new owner (empty for saeburn).
+		* Scope: self
+		*/
+		TABLE sevent {
+			uint64_t				slot;
+			uint64_t				seq;
+			name					type;
+			name					author;
+			name					from;
+			name					to;
+			uint64_t				cdate;
+			std::vector<uint64_t>	assetids;
+
+			auto primary_key() const {
+				return slot;
+			}
+		};
+
+		typedef sa_table< eosio::multi_index< "events"_n, sevent > > events;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Ownership commitment, see setmerkle. Depth 64 sparse Merkle tree keyed by assetid:
+		*   leaf       = sha256( assetid || owner ), both uint64 little endian; empty leaf = 0;
+		*   inner node = sha256( left || right ), or 0 if both children are 0.
+		* Scope: self
+		*/
+		TABLE smerkle {
+			checksum256	root;
+			bool		enabled = false;
+
+			EOSLIB_SERIALIZE( smerkle, (root)(enabled) )
+		};
+
+		typedef eosio::singleton< "merkle"_n, smerkle> merkleconf;
+		smerkle _mstate;
+		bool _mloaded = false;
+		saarena::map< uint64_t, checksum256 > _mleaves;		// leaves changed by this action
+
+		/*
+		* Inner node with both children. The row at level l (scope, 0 - root) and prefix p holds the
+		* hashes of the subtrees with (l+1) bit prefixes 2p (left) and 2p+1 (right); level 63 rows
+		* hold leaves. Rows of empty subtrees are erased.
+		* Scope: level
+		*/
+		TABLE smnode {
+			uint64_t	prefix;
+			checksum256	left;
+			checksum256	right;
+
+			auto primary_key() const {
+				return prefix;
+			}
+		};
+
+		typedef sa_table< eosio::multi_index< "mnodes"_n, smnode > > mnodes;
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Size counters of the sassets, offers, offerfs and delegates tables (all scopes), updated
+		* on every insert and erase. rows of offers / delegates is the number of open offers /
+		* active delegations. bytes is approximate: serialized row + 112 bytes overhead per row,
+		* offers count their recipient copy too. Counters start at zero unless seeded by setstats.
+		* Scope: self
+		*/
+		TABLE tablestat {
+			name		table;
+			int64_t		rows	= 0;
+			int64_t		bytes	= 0;
+
+			auto primary_key() const {
+				return table.value;
+			}
+		};
+
+		typedef sa_table< eosio::multi_index< "tablestats"_n, tablestat > > tablestats;
+		saarena::map< name, tablestat > _tsdelta;		// changes by this action
+
+
 		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 		/*
 		* Helps external contracts parse actions and tables correctly (Usefull for decentralized exchanges,
@@ -670,6 +1310,83 @@ CONTRACT SimpleAssets : public contract {
 
 		typedef singleton<"tokenconfigs"_n, tokenconfigs> Configs;
 
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Open offer and delegation lookups. Rows live in the scope of the account holding the
+		* asset (offers are mirrored in the recipient scope), so lookups and inserts only touch
+		* that user's rows. Until migrate has emptied the self scoped tables, rows not found
+		* there are looked up in them as well (legacy == true).
+		*/
+		template<typename T>
+		struct rowref {
+			bool	found	= false;
+			bool	legacy	= false;
+			T		row;
+		};
+
+		bool hasLegacy();
+		bool _legacyloaded = false;
+		bool _legacy = true;
+
+		rowref<soffer> findOffer( name holder, uint64_t assetid );
+		rowref<soffer> findOfferTo( name recipient, uint64_t assetid );
+		void addOffer( name payer, const soffer& o );
+		void eraseOffer( const rowref<soffer>& r );
+
+		rowref<sofferf> findOfferf( name owner, uint64_t id );
+		rowref<sofferf> findOfferfTo( name recipient, uint64_t id );
+		void addOfferf( name payer, const sofferf& o );
+		void eraseOfferf( const rowref<sofferf>& r );
+		bool hasOfferf( name owner, name author, symbol sym, name offeredto );
+
+		rowref<sdelegate> findDelegate( name holder, uint64_t assetid );
+		rowref<sapproval> findOperator( name owner );
+		static bool approves( const sapproval& a, name author );
+		static bool expired( const sdelegate& d );
+		bool bulkSkip( name holder, const sasset& a, name author, name category );
+		sassets::const_iterator moveAsset( sassets& from_t, sassets::const_iterator itr, sassets& to_t, name owner, name payer );
+		sassets::const_iterator materialize( sassets& assets_f, name owner, uint64_t assetid, name payer );
+		void addDelegate( name payer, const sdelegate& d );
+		void eraseDelegate( const rowref<sdelegate>& r );
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* Batch engine of the NFT actions that take a list of asset ids. The policy of an action
+		* says which rows to look up and how (lookup), and provides the validate / apply steps;
+		* see batch in SimpleAssets.cpp.
+		*/
+		enum class lookup : uint8_t {
+			skip,		// not looked up
+			absent,		// must not exist, checked by the engine
+			load		// looked up and passed to the policy
+		};
+
+		// Policy::expire - return assets whose delegation has expired to the owner instead
+		// Policy::lazy - create the sassets row of a drop edition not created yet (see createdrop),
+		// paid by p.rampayer
+		struct batchitem {
+			uint64_t				id;
+			sassets::const_iterator	itr;		// asset row, if Policy::row
+			rowref<soffer>			offer;		// if Policy::offer == lookup::load
+			rowref<sdelegate>		delegate;	// if Policy::delegate == lookup::load
+		};
+
+		template<typename Policy>
+		void batch( Policy& p, sassets& assets_f, std::vector<uint64_t>& assetids );
+
+		void reclaimAsset( sassets& assets_f, const batchitem& b, name payer );
+
+		struct transferpolicy;
+		struct burnpolicy;
+		struct offerpolicy;
+		struct cancelofferpolicy;
+		struct delegatepolicy;
+		struct undelegatepolicy;
+		struct attachpolicy;
+		struct reclaimpolicy;
+
 };
 
 //============================================================================================================
@@ -0,0 +1,122 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Per-action bump allocator for the contract's transient containers (author groupings of
+ *  asset ids and the like). Allocation is a pointer bump in a static buffer, deallocation
+ *  only gives back the most recent block, and the whole arena is reset when the action ends
+ *  (contract destructor). Requests that do not fit go to malloc.
+ *
+ *    saarena::map< name, saarena::vector<uint64_t> > uniqauthor;
+ *
+ *  Containers pack like their std counterparts, so they can be passed to actions and events.
+ *  No eosiolib dependency, the native benchmark (native/bench/arena_bench.cpp) includes it too.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+namespace saarena {
+
+	class arena {
+		public:
+			static constexpr size_t capacity = 16 * 1024;
+
+			void* allocate( size_t size, size_t align ) {
+				size_t at = ( used + align - 1 ) & ~( align - 1 );
+				if ( at + size > capacity ) {
+					fallbacks++;
+					return malloc( size );
+				}
+				last = at;
+				used = at + size;
+				allocs++;
+				return buf + at;
+			}
+
+			void deallocate( void* p, size_t size ) {
+				char* c = static_cast<char*>( p );
+				if ( c < buf || c >= buf + capacity ) {
+					free( p );
+					return;
+				}
+				if ( c == buf + last && last + size == used )
+					used = last;		// most recent block, e.g. a vector growing
+			}
+
+			void reset() {
+				used = last = 0;
+			}
+
+			size_t		used		= 0;
+			size_t		last		= 0;
+			uint32_t	allocs		= 0;
+			uint32_t	fallbacks	= 0;
+
+		private:
+			alignas( 16 ) char buf[capacity];
+	};
+
+	inline arena& instance() {
+		static arena a;
+		return a;
+	}
+
+
+	template<typename T>
+	struct allocator {
+		using value_type = T;
+
+		allocator() = default;
+		template<typename U> allocator( const allocator<U>& ) {}
+
+		T* allocate( size_t n ) {
+			return static_cast<T*>( instance().allocate( n * sizeof( T ), alignof( T ) ) );
+		}
+
+		void deallocate( T* p, size_t n ) {
+			instance().deallocate( p, n * sizeof( T ) );
+		}
+
+		template<typename U> bool operator==( const allocator<U>& ) const { return true; }
+		template<typename U> bool operator!=( const allocator<U>& ) const { return false; }
+	};
+
+	template<typename T>
+	using vector = std::vector< T, allocator<T> >;
+
+	template<typename K, typename V>
+	using map = std::map< K, V, std::less<K>, allocator< std::pair<const K, V> > >;
+
+
+	// serialization, same format as std::vector / std::map (varuint32 size, then the elements)
+	template<typename DataStream>
+	void write_size( DataStream& ds, uint32_t n ) {
+		do {
+			char b = char( n & 0x7f );
+			n >>= 7;
+			b |= char( n ? 0x80 : 0 );
+			ds.write( &b, 1 );
+		} while( n );
+	}
+
+	template<typename DataStream, typename T>
+	DataStream& operator<<( DataStream& ds, const vector<T>& v ) {
+		write_size( ds, v.size() );
+		for( const auto& e : v )
+			ds << e;
+		return ds;
+	}
+
+	template<typename DataStream, typename K, typename V>
+	DataStream& operator<<( DataStream& ds, const map<K, V>& m ) {
+		write_size( ds, m.size() );
+		for( const auto& e : m )
+			ds << e.first << e.second;
+		return ds;
+	}
+}
@@ -0,0 +1,154 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Optional per-action resource counters. Only active when the contract is built with
+ *  SA_INSTRUMENT defined (cmake -DSA_INSTRUMENT=ON), otherwise every hook compiles away.
+ *
+ *  Counters are collected for one action and printed to the console (visible in the action
+ *  trace) when the contract object is destroyed at the end of the action:
+ *
+ *    SA-STATS find=4 store=1 update=1 remove=1 bytes=412 inline=0 deferred=1 ram=[lioninjungle:+331 <payer>:-214]
+ *
+ *  find/store/update/remove - multi_index primary table calls (db_find / db_store / db_update / db_remove);
+ *  bytes                    - bytes serialized into rows by store and update;
+ *  inline / deferred        - inline actions and deferred transactions emitted;
+ *  ram                      - approximate RAM delta per payer. Row overhead is included for stores and
+ *                             removes. Rows erased or modified with same_payer are reported as <payer>,
+ *                             because the current payer of a row is not visible to the contract.
+ */
+
+#pragma once
+
+#ifdef SA_INSTRUMENT
+
+#include <eosiolib/eosio.hpp>
+
+namespace sainstrument {
+
+	using eosio::name;
+
+	// billable overhead of one primary key row (key_value_object), see chain/config.hpp
+	static constexpr int64_t row_overhead = 112;
+
+	struct ramdelta {
+		name		payer;
+		int64_t		bytes;
+	};
+
+	struct counters {
+		uint32_t				finds		= 0;
+		uint32_t				stores		= 0;
+		uint32_t				updates		= 0;
+		uint32_t				removes		= 0;
+		uint64_t				bytes		= 0;
+		uint32_t				inlines		= 0;
+		uint32_t				deferred	= 0;
+		std::vector<ramdelta>	ram;
+
+		void addram( name payer, int64_t delta ) {
+			for( auto& r : ram ) {
+				if ( r.payer == payer ) {
+					r.bytes += delta;
+					return;
+				}
+			}
+			ram.push_back( ramdelta{ payer, delta } );
+		}
+
+		void print() const {
+			eosio::print( "SA-STATS find=", finds, " store=", stores, " update=", updates, " remove=", removes,
+				" bytes=", bytes, " inline=", inlines, " deferred=", deferred, " ram=[" );
+
+			for( size_t i = 0; i < ram.size(); ++i ) {
+				if ( i != 0 ) eosio::print( " " );
+				if ( ram[i].payer == eosio::same_payer )
+					eosio::print( "<payer>" );
+				else
+					eosio::print( ram[i].payer );
+				eosio::print( ":", ram[i].bytes > 0 ? "+" : "", ram[i].bytes );
+			}
+			eosio::print( "]\n" );
+		}
+	};
+
+	inline counters& stats() {
+		static counters c;
+		return c;
+	}
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	/*
+	* Drop-in wrapper around eosio::multi_index which counts primary table calls.
+	* Secondary index walks (get_index) are not counted.
+	*/
+	template<typename MI>
+	class instrumented_index : public MI {
+		public:
+			using MI::MI;
+			using typename MI::const_iterator;
+
+			const_iterator find( uint64_t primary ) const {
+				++stats().finds;
+				return MI::find( primary );
+			}
+
+			template<typename... Args>
+			const auto& get( Args&&... args ) const {
+				++stats().finds;
+				return MI::get( std::forward<Args>(args)... );
+			}
+
+			template<typename Lambda>
+			const_iterator emplace( name payer, Lambda&& constructor ) {
+				auto itr = MI::emplace( payer, std::forward<Lambda>(constructor) );
+				int64_t size = eosio::pack_size( *itr );
+
+				++stats().stores;
+				stats().bytes += size;
+				stats().addram( payer, size + row_overhead );
+				return itr;
+			}
+
+			template<typename Obj, typename Lambda>
+			void modify( const Obj& obj, name payer, Lambda&& updater ) {
+				const auto& row = deref( obj );
+				int64_t before = eosio::pack_size( row );
+				MI::modify( obj, payer, std::forward<Lambda>(updater) );
+				int64_t after = eosio::pack_size( row );
+
+				++stats().updates;
+				stats().bytes += after;
+				stats().addram( payer, after - before );
+			}
+
+			template<typename Obj>
+			auto erase( const Obj& obj ) {
+				int64_t size = eosio::pack_size( deref( obj ) );
+
+				++stats().removes;
+				stats().addram( eosio::same_payer, -( size + row_overhead ) );
+				return MI::erase( obj );
+			}
+
+		private:
+			static const auto& deref( const const_iterator& itr ) { return *itr; }
+
+			template<typename T>
+			static const T& deref( const T& obj ) { return obj; }
+	};
+}
+
+#define SA_COUNT( counter ) ( ++sainstrument::stats().counter )
+
+template<typename MI>
+using sa_table = sainstrument::instrumented_index<MI>;
+
+#else
+
+#define SA_COUNT( counter )
+
+template<typename MI>
+using sa_table = MI;
+
+#endif
@@ -0,0 +1,192 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Read API for contracts that integrate with SimpleAssets (games, markets, item shops).
+ *  Header-only, does not need SimpleAssets.hpp.
+ *
+ *  multi_index::find deserializes the whole sasset row, including idata, mdata and the nested
+ *  container, even when only the owner or author is needed. These helpers read rows with
+ *  db_find_i64 / db_get_i64 directly and copy only the fixed-size prefix of a row:
+ *
+ *    if ( sareader::owns( "simpleassets"_n, player, assetid ) ) ...
+ *
+ *    sareader::sasset_head h;
+ *    if ( sareader::get_head( "simpleassets"_n, player, assetid, h ) && h.author == get_self() ) ...
+ *
+ *    asset gold = sareader::balance_of( "simpleassets"_n, player, get_self(), symbol( "GOLD", 0 ) );
+ *
+ *  contract - account SimpleAssets is deployed to.
+ */
+
+#pragma once
+
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/asset.hpp>
+#include <eosiolib/db.h>
+
+#include <cstring>
+
+namespace sareader {
+
+	using eosio::name;
+	using eosio::symbol;
+	using eosio::asset;
+
+	// fixed-size prefix of a sasset row (idata, mdata, container and containerf follow it)
+	struct sasset_head {
+		uint64_t	id;
+		name		owner;
+		name		author;
+		name		category;
+	};
+
+	namespace detail {
+		// copies the first `size` bytes of the row, returns false if the row does not exist
+		// or is shorter than that
+		inline bool read_prefix( name contract, name scope, name table, uint64_t pk, void* out, uint32_t size ) {
+			int32_t itr = db_find_i64( contract.value, scope.value, table.value, pk );
+			if ( itr < 0 )
+				return false;
+			return db_get_i64( itr, out, size ) >= int32_t( size );
+		}
+
+		inline bool exists( name contract, name scope, name table, uint64_t pk ) {
+			return db_find_i64( contract.value, scope.value, table.value, pk ) >= 0;
+		}
+
+		inline uint64_t u64( const char* p ) {
+			uint64_t v;
+			memcpy( &v, p, sizeof( v ) );
+			return v;
+		}
+
+		// reads varuint size at `pos` of a row copied into buf[0, len); returns the offset of the
+		// data and sets `size`, or 0 if the row is cut short
+		inline uint32_t vector_at( const char* buf, uint32_t len, uint32_t pos, uint32_t& size ) {
+			size = 0;
+			for( uint32_t shift = 0; pos < len; shift += 7 ) {
+				uint8_t b = uint8_t( buf[pos++] );
+				size |= uint32_t( b & 0x7f ) << shift;
+				if ( !( b & 0x80 ) )
+					return pos;
+			}
+			return 0;
+		}
+
+		inline bool bit_set( const char* buf, uint32_t len, uint32_t pos, uint64_t bit ) {
+			uint32_t size;
+			pos = vector_at( buf, len, pos, size );
+			return pos && bit / 8 < size && pos + bit / 8 < len && ( uint8_t( buf[pos + bit / 8] ) >> ( bit % 8 ) & 1 );
+		}
+
+		/*
+		* Edition {{assetid}} of a drop of {{owner}} whose sassets row was not created yet (see
+		* createdrop). Reads the drop prefix up to done and the dropbits row of the edition's chunk.
+		*/
+		inline bool drop_head( name contract, name owner, uint64_t assetid, sasset_head& h ) {
+			// sdrop: last (8), first (8), author (8), category (8), owner (8), left (8), done (varuint size + bytes)
+			int32_t itr = db_lowerbound_i64( contract.value, owner.value, "drops"_n.value, assetid );
+			if ( itr < 0 )
+				return false;
+
+			const uint64_t chunk_size = 1024;		// SimpleAssets::dropchunk
+			char head[48 + 2 + 123];				// done of a drop of at most 1000000 editions
+			uint32_t len = uint32_t( db_get_i64( itr, head, sizeof( head ) ) );
+			if ( len < 49 || u64( head + 8 ) > assetid )
+				return false;
+
+			uint64_t chunk = ( assetid - u64( head + 8 ) ) / chunk_size;
+			if ( bit_set( head, len, 48, chunk ) )
+				return false;
+
+			// sdropbits: base (8), left (8), taken (varuint size + bytes)
+			uint64_t base = u64( head + 8 ) + chunk * chunk_size;
+			char bits[16 + 2 + chunk_size / 8];
+			int32_t c = db_find_i64( contract.value, owner.value, "dropbits"_n.value, base );
+			if ( c >= 0 && bit_set( bits, uint32_t( db_get_i64( c, bits, sizeof( bits ) ) ), 16, assetid - base ) )
+				return false;
+
+			h.id		= assetid;
+			h.owner		= name( u64( head + 32 ) );
+			h.author	= name( u64( head + 16 ) );
+			h.category	= name( u64( head + 24 ) );
+			return true;
+		}
+	}
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	/*
+	* Reads id, owner, author and category of asset {{assetid}} held by {{owner}}, including drop
+	* editions that have no sassets row yet.
+	*/
+	inline bool get_head( name contract, name owner, uint64_t assetid, sasset_head& h ) {
+		char buf[32];
+		if ( !detail::read_prefix( contract, owner, "sassets"_n, assetid, buf, sizeof( buf ) ) )
+			return detail::drop_head( contract, owner, assetid, h );
+
+		h.id		= detail::u64( buf );
+		h.owner		= name( detail::u64( buf + 8 ) );
+		h.author	= name( detail::u64( buf + 16 ) );
+		h.category	= name( detail::u64( buf + 24 ) );
+		return true;
+	}
+
+
+	/*
+	* True if {{account}} holds asset {{assetid}}. Assets are stored in the scope of their holder,
+	* so this is a single lookup and no row data is read. A borrowed (delegated) asset is held by
+	* the borrower. Drop editions that have no sassets row yet take lookups in drops and dropbits.
+	*/
+	inline bool owns( name contract, name account, uint64_t assetid ) {
+		sasset_head h;
+		return detail::exists( contract, account, "sassets"_n, assetid ) ||
+		       detail::drop_head( contract, account, assetid, h );
+	}
+
+
+	/*
+	* True if asset {{assetid}} held by {{holder}} has an open offer or is delegated, i.e. can not
+	* be transferred by the holder right now.
+	*/
+	inline bool locked( name contract, name holder, uint64_t assetid ) {
+		return detail::exists( contract, holder, "offersown"_n, assetid ) ||
+		       detail::exists( contract, holder, "delegatesto"_n, assetid ) ||
+		       detail::exists( contract, contract, "offers"_n, assetid ) ||
+		       detail::exists( contract, contract, "delegates"_n, assetid );
+	}
+
+
+	/*
+	* Balance of fungible token {{sym}} created by {{author}} in {{account}}'s accounts table, plus
+	* its balance shards if the account has sharded balances (see setshards).
+	* Returns zero if the token or the balance rows do not exist.
+	*/
+	inline asset balance_of( name contract, name account, name author, symbol sym ) {
+		asset res( 0, sym );
+
+		// currency_stats prefix: supply (16), max_supply (16), issuer (8), id (8)
+		char st[48];
+		if ( !detail::read_prefix( contract, author, "stat"_n, sym.code().raw(), st, sizeof( st ) ) )
+			return res;
+		uint64_t ftid = detail::u64( st + 40 );
+
+		// account: id (8), author (8), balance.amount (8), balance.symbol (8)
+		char ac[32];
+		if ( detail::read_prefix( contract, account, "accounts"_n, ftid, ac, sizeof( ac ) ) && detail::u64( ac + 24 ) == sym.raw() )
+			res.amount = int64_t( detail::u64( ac + 16 ) );
+
+		// accshard: key (8) = ftid * 16 + shard, balance.amount (8), balance.symbol (8)
+		uint64_t pk;
+		int32_t itr = db_lowerbound_i64( contract.value, account.value, "accshards"_n.value, ftid << 4 );
+		for( ; itr >= 0; itr = db_next_i64( itr, &pk ) ) {
+			char sh[24];
+			if ( db_get_i64( itr, sh, sizeof( sh ) ) < int32_t( sizeof( sh ) ) || ( detail::u64( sh ) >> 4 ) != ftid )
+				break;
+			if ( detail::u64( sh + 16 ) == sym.raw() )
+				res.amount += int64_t( detail::u64( sh + 8 ) );
+		}
+		return res;
+	}
+}
@@ -0,0 +1,185 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Arena benchmark: the per-action work of transfer / claim / detach done the old way (std
+ *  containers for the author grouping, asset rows copied field by field, containers rebuilt
+ *  on detach) vs. the current way (saarena containers, rows moved, containers edited in place).
+ *  Heap allocations are counted by replacing the global operator new, arena allocations by the
+ *  counters of saarena::arena.
+ *
+ *  Synthetic: rows are plain structs, without the multi_index row cache and without the
+ *  pack / unpack of every row read and written on chain, which neither way avoids. The
+ *  difference is an upper bound of the saving in the contract, not a measurement of it;
+ *  measure actions on a local chain (tools/loadgen.sh, saprof) for that.
+ *
+ *  Usage: sa_arena_bench [actions] [assets per action]
+ */
+
+#include <SimpleAssetsArena.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <new>
+#include <string>
+
+namespace {
+
+	std::atomic<uint64_t> heap_allocs( 0 );
+
+	struct row {
+		uint64_t			id = 0;
+		uint64_t			owner = 0;
+		uint64_t			author = 0;
+		uint64_t			category = 0;
+		std::string			idata;
+		std::string			mdata;
+		std::vector<row>	container;
+	};
+
+	row make_row( uint64_t id, size_t children ) {
+		row r;
+		r.id = id;
+		r.owner = 1;
+		r.author = id % 3 + 1;
+		r.category = 7;
+		r.idata = "{\"name\": \"Sword of the north\", \"img\": \"https://img.example.com/items/" + std::to_string( id ) + ".png\"}";
+		r.mdata = "{\"level\": 12, \"durability\": 87, \"owner_note\": \"kept in the main inventory slot\"}";
+		for( size_t i = 0; i < children; ++i )
+			r.container.push_back( make_row( id * 100 + i, 0 ) );
+		return r;
+	}
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	// one transfer action: group ids by author, move every row to the new owner's table
+
+	uint64_t transfer_copy( std::vector<row>& from, std::vector<row>& to ) {
+		std::map< uint64_t, std::vector<uint64_t> > uniqauthor;
+		for( auto& r : from ) {
+			row s;
+			s.id = r.id;
+			s.owner = 2;
+			s.author = r.author;
+			s.category = r.category;
+			s.idata = r.idata;
+			s.mdata = r.mdata;
+			s.container = r.container;
+			to.push_back( s );
+			uniqauthor[r.author].push_back( r.id );
+		}
+		from.clear();
+		return uniqauthor.size();
+	}
+
+	uint64_t transfer_move( std::vector<row>& from, std::vector<row>& to ) {
+		saarena::map< uint64_t, saarena::vector<uint64_t> > uniqauthor;
+		for( auto& r : from ) {
+			uniqauthor[r.author].push_back( r.id );
+			to.emplace_back( std::move( r ) );
+			to.back().owner = 2;
+		}
+		from.clear();
+		uint64_t n = uniqauthor.size();
+		uniqauthor.clear();
+		saarena::instance().reset();
+		return n;
+	}
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	// one detach action: take two children out of a container asset
+
+	uint64_t detach_rebuild( row& parent, std::vector<row>& table ) {
+		for( uint64_t id : { parent.container.front().id, parent.container.back().id } ) {
+			std::vector<row> newcontainer;
+			for( size_t j = 0; j < parent.container.size(); ++j ) {
+				auto acc = parent.container[j];
+				if ( acc.id == id )
+					table.push_back( acc );
+				else
+					newcontainer.push_back( acc );
+			}
+			parent.container = newcontainer;
+		}
+		return parent.container.size();
+	}
+
+	uint64_t detach_inplace( row& parent, std::vector<row>& table ) {
+		for( uint64_t id : { parent.container.front().id, parent.container.back().id } ) {
+			for( auto it = parent.container.begin(); it != parent.container.end(); ++it ) {
+				if ( it->id == id ) {
+					table.push_back( std::move( *it ) );
+					parent.container.erase( it );
+					break;
+				}
+			}
+		}
+		return parent.container.size();
+	}
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+	// runs `f` once per action on freshly built rows; only the time and allocations of `f` count
+	template<typename Setup, typename F>
+	void run( const char* label, size_t actions, Setup setup, F f ) {
+		double secs = 0;
+		uint64_t allocs = 0, arena_allocs = 0, check = 0;
+		for( size_t i = 0; i < actions; ++i ) {
+			auto state = setup( i );
+			uint64_t before = heap_allocs.load( std::memory_order_relaxed );
+			uint32_t arena_before = saarena::instance().allocs;
+			auto start = std::chrono::steady_clock::now();
+			check += f( state );
+			secs += std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+			allocs += heap_allocs.load( std::memory_order_relaxed ) - before;
+			arena_allocs += saarena::instance().allocs - arena_before;
+		}
+		printf( "%-34s %9.0f ns/action  %8.1f heap allocs/action  %8.1f arena allocs/action  (check %llu)\n", label,
+			secs * 1e9 / actions, double( allocs ) / actions, double( arena_allocs ) / actions, (unsigned long long)check );
+	}
+}
+
+void* operator new( size_t size ) {
+	heap_allocs.fetch_add( 1, std::memory_order_relaxed );
+	if ( void* p = malloc( size ? size : 1 ) )
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete( void* p ) noexcept { free( p ); }
+void operator delete( void* p, size_t ) noexcept { free( p ); }
+
+
+int main( int argc, char** argv ) {
+	size_t actions = argc > 1 ? std::stoul( argv[1] ) : 20000;
+	size_t assets = argc > 2 ? std::stoul( argv[2] ) : 20;
+
+	printf( "%zu actions, %zu assets per transfer, containers of %zu assets\n", actions, assets, assets );
+	printf( "synthetic rows, no multi_index pack / unpack: an upper bound of the contract's saving\n\n" );
+
+	struct tables { std::vector<row> from, to; };
+	auto transfer_setup = [&]( size_t i ) {
+		tables t;
+		for( size_t k = 0; k < assets; ++k )
+			t.from.push_back( make_row( i * assets + k, k % 4 == 0 ? 2 : 0 ) );
+		t.to.reserve( assets );
+		return t;
+	};
+	run( "transfer: std containers, copy", actions, transfer_setup, []( tables& t ) { return transfer_copy( t.from, t.to ); } );
+	run( "transfer: arena, move", actions, transfer_setup, []( tables& t ) { return transfer_move( t.from, t.to ); } );
+
+	struct parent { row p; std::vector<row> table; };
+	auto detach_setup = [&]( size_t i ) {
+		parent p{ make_row( i, assets ), {} };
+		p.table.reserve( 2 );
+		return p;
+	};
+	run( "detach: rebuild container", actions, detach_setup, []( parent& p ) { return detach_rebuild( p.p, p.table ); } );
+	run( "detach: in place, move", actions, detach_setup, []( parent& p ) { return detach_inplace( p.p, p.table ); } );
+
+	printf( "\narena fallbacks to malloc: %u\n", saarena::instance().fallbacks );
+	return 0;
+}
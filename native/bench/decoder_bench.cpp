@@ -0,0 +1,185 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Decoder benchmark: zero-copy decoder vs. generic ABI driven binary -> JSON conversion
+ *  (the way indexers use abi_serializer: look up struct and field types by name, build JSON text,
+ *  then parse the fields they need back out of it).
+ *
+ *  Usage: sa_decoder_bench [rows]
+ */
+
+#include <simpleassets/decoder.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+using namespace simpleassets;
+
+namespace {
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	// test data
+
+	void put_u64( std::string& out, uint64_t v ) { out.append( (const char*)&v, 8 ); }
+
+	void put_varuint32( std::string& out, uint32_t v ) {
+		do {
+			uint8_t b = v & 0x7f;
+			v >>= 7;
+			out += char( b | ( v ? 0x80 : 0 ) );
+		} while( v );
+	}
+
+	void put_str( std::string& out, std::string_view s ) {
+		put_varuint32( out, s.size() );
+		out.append( s );
+	}
+
+	std::string make_sasset( uint64_t id, bool nested ) {
+		std::string row;
+		put_u64( row, id );
+		put_u64( row, "lioninjungle"_n.value );
+		put_u64( row, "gameauthor11"_n.value );
+		put_u64( row, "weapon"_n.value );
+		put_str( row, "{\"name\":\"Magic Sword\",\"power\":10,\"speed\":2.2,\"img\":\"https://example.com/img/sword.png\",\"desc\":\"A sword forged in the fires of the blockchain\"}" );
+		put_str( row, "{\"color\":\"bluegold\",\"level\":3,\"stamina\":5}" );
+
+		if ( nested ) {
+			put_varuint32( row, 1 );
+			row += make_sasset( id + 1, false );
+		} else {
+			put_varuint32( row, 0 );
+		}
+
+		put_varuint32( row, 1 );
+		put_u64( row, 1000001 );
+		put_u64( row, "gameauthor11"_n.value );
+		put_u64( row, 12345 );
+		put_u64( row, symbol( "GOLD", 2 ).value );
+		return row;
+	}
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	// baseline: generic ABI walker producing JSON
+
+	struct abi_field { std::string name, type; };
+
+	std::map<std::string, std::vector<abi_field>> abi_structs = {
+		{ "account", { { "id", "uint64" }, { "author", "name" }, { "balance", "asset" } } },
+		{ "sasset",  { { "id", "uint64" }, { "owner", "name" }, { "author", "name" }, { "category", "name" },
+		               { "idata", "string" }, { "mdata", "string" }, { "container", "sasset[]" }, { "containerf", "account[]" } } },
+	};
+
+	void json_escape( std::string& out, std::string_view s ) {
+		out += '"';
+		for( char c : s ) {
+			if ( c == '"' || c == '\\' ) out += '\\';
+			out += c;
+		}
+		out += '"';
+	}
+
+	void to_json( reader& rd, const std::string& type, std::string& out ) {
+		if ( type.size() > 2 && type.compare( type.size() - 2, 2, "[]" ) == 0 ) {
+			std::string elem = type.substr( 0, type.size() - 2 );
+			uint32_t n = rd.varuint32();
+			out += '[';
+			for( uint32_t i = 0; i < n; ++i ) {
+				if ( i ) out += ',';
+				to_json( rd, elem, out );
+			}
+			out += ']';
+		} else if ( type == "uint64" ) {
+			out += '"' + std::to_string( rd.u64() ) + '"';
+		} else if ( type == "name" ) {
+			out += '"' + rd.nm().to_string() + '"';
+		} else if ( type == "string" ) {
+			json_escape( out, rd.str() );
+		} else if ( type == "asset" ) {
+			out += '"' + rd.quantity().to_string() + '"';
+		} else {
+			const auto& fields = abi_structs.at( type );
+			out += '{';
+			for( size_t i = 0; i < fields.size(); ++i ) {
+				if ( i ) out += ',';
+				json_escape( out, fields[i].name );
+				out += ':';
+				to_json( rd, fields[i].type, out );
+			}
+			out += '}';
+		}
+	}
+
+	// what an indexer does with the JSON: pull out owner and author again
+	uint64_t json_consume( const std::string& json ) {
+		uint64_t h = 0;
+		for( const char* key : { "\"owner\":\"", "\"author\":\"" } ) {
+			auto p = json.find( key );
+			auto e = json.find( '"', p + strlen( key ) );
+			h += name( std::string_view( json ).substr( p + strlen( key ), e - p - strlen( key ) ) ).value;
+		}
+		return h;
+	}
+
+	template<typename F>
+	double run( const char* label, size_t rows, F&& f ) {
+		auto start = std::chrono::steady_clock::now();
+		uint64_t check = f();
+		double secs = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+		printf( "%-28s %10.0f rows/s  %8.1f ns/row  (check %llu)\n", label, rows / secs, secs * 1e9 / rows, (unsigned long long)check );
+		return secs;
+	}
+}
+
+int main( int argc, char** argv ) {
+	size_t rows = argc > 1 ? strtoull( argv[1], nullptr, 10 ) : 200000;
+
+	std::vector<std::string> data;
+	data.reserve( rows );
+	for( size_t i = 0; i < rows; ++i )
+		data.push_back( make_sasset( 100000000000000 + i, i % 4 == 0 ) );
+
+	printf( "%zu sasset rows, %zu bytes each (avg)\n\n", rows, data[0].size() );
+
+	double json = run( "abi -> json -> fields", rows, [&] {
+		uint64_t h = 0;
+		std::string out;
+		for( const auto& row : data ) {
+			reader rd( row );
+			out.clear();
+			to_json( rd, "sasset", out );
+			h += json_consume( out );
+		}
+		return h;
+	});
+
+	double zc = run( "zero-copy decode", rows, [&] {
+		uint64_t h = 0;
+		sasset_view a;
+		for( const auto& row : data ) {
+			decode( row, a );
+			h += a.owner.value + a.author.value;
+		}
+		return h;
+	});
+
+	run( "zero-copy decode + nested", rows, [&] {
+		uint64_t h = 0;
+		sasset_view a;
+		for( const auto& row : data ) {
+			decode( row, a );
+			for( const auto& c : a.container )
+				h += c.id + c.idata.size();
+			for( const auto& f : a.containerf )
+				h += f.balance.amount;
+		}
+		return h;
+	});
+
+	printf( "\nspeedup: %.1fx\n", json / zc );
+	return 0;
+}
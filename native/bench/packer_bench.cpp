@@ -0,0 +1,225 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Packer benchmark: typed action packing into reusable buffers vs. generic JSON -> binary
+ *  ABI serialization (the way bots use abi_serializer: build JSON args, parse them, then
+ *  serialize every field by looking its type up in the ABI).
+ *
+ *  Usage: sa_packer_bench [actions]
+ */
+
+#include <simpleassets/packer.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+
+using namespace simpleassets;
+
+namespace {
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	// baseline: JSON args -> generic ABI serializer
+
+	struct abi_field { std::string name, type; };
+
+	std::map<std::string, std::vector<abi_field>> abi_structs = {
+		{ "create",    { { "author", "name" }, { "category", "name" }, { "owner", "name" }, { "idata", "string" },
+		                 { "mdata", "string" }, { "requireclaim", "bool" } } },
+		{ "transfer",  { { "from", "name" }, { "to", "name" }, { "assetids", "uint64[]" }, { "memo", "string" } } },
+		{ "issuef",    { { "to", "name" }, { "author", "name" }, { "quantity", "asset" }, { "memo", "string" } } },
+		{ "transferf", { { "from", "name" }, { "to", "name" }, { "author", "name" }, { "quantity", "asset" }, { "memo", "string" } } },
+	};
+
+	// flat JSON object parser: string, number, bool and array-of-number values, kept as text
+	std::map<std::string, std::string> parse_json( const std::string& json ) {
+		std::map<std::string, std::string> out;
+		size_t p = 1;
+		while( p < json.size() && json[p] != '}' ) {
+			size_t ks = json.find( '"', p ) + 1, ke = json.find( '"', ks );
+			std::string key = json.substr( ks, ke - ks );
+			p = ke + 2;
+
+			size_t ve;
+			if ( json[p] == '"' ) {
+				std::string& v = out[key];
+				for( ve = p + 1; json[ve] != '"'; ++ve ) {
+					if ( json[ve] == '\\' ) ++ve;
+					v += json[ve];
+				}
+				++ve;
+			} else {
+				ve = json[p] == '[' ? json.find( ']', p ) + 1 : json.find_first_of( ",}", p );
+				out[key] = json.substr( p, ve - p );
+			}
+			p = json[ve] == ',' ? ve + 1 : ve;
+		}
+		return out;
+	}
+
+	asset parse_asset( const std::string& s ) {
+		auto sp = s.find( ' ' ), dot = s.find( '.' );
+		std::string digits = s.substr( 0, sp );
+		uint8_t precision = dot < sp ? sp - dot - 1 : 0;
+		if ( dot < sp ) digits.erase( dot, 1 );
+		asset a;
+		a.amount = std::stoll( digits );
+		a.sym = symbol( s.substr( sp + 1 ), precision );
+		return a;
+	}
+
+	void abi_pack( writer& w, const std::string& type, const std::string& value ) {
+		if ( type == "name" ) {
+			w.nm( name( value ) );
+		} else if ( type == "string" ) {
+			w.str( value );
+		} else if ( type == "bool" ) {
+			w.boolean( value == "true" );
+		} else if ( type == "asset" ) {
+			w.quantity( parse_asset( value ) );
+		} else if ( type == "uint64[]" ) {
+			std::vector<uint64_t> ids;
+			for( size_t p = 1; p < value.size() - 1; ) {
+				size_t e = value.find_first_of( ",]", p );
+				ids.push_back( std::stoull( value.substr( p, e - p ) ) );
+				p = e + 1;
+			}
+			pack( w, id_list( ids ) );
+		}
+	}
+
+	std::string abi_json_to_bin( const std::string& action, const std::string& json ) {
+		auto args = parse_json( json );
+		writer w;
+		for( const auto& f : abi_structs.at( action ) )
+			abi_pack( w, f.type, args.at( f.name ) );
+		return std::string( w.data() );
+	}
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	// workload: the action mix of a minting / payout bot
+
+	const char* idata = "{\"name\":\"Magic Sword\",\"power\":10,\"speed\":2.2,\"img\":\"https://example.com/img/sword.png\"}";
+	const char* mdata = "{\"color\":\"bluegold\",\"level\":3}";
+
+	const name author( "gameauthor11" ), category( "weapon" ), treasury( "gametreasury" ), contract( "simpleassets" );
+	const symbol gold( "GOLD", 4 );
+
+	std::string escape( std::string_view s ) {
+		std::string out;
+		for( char c : s ) {
+			if ( c == '"' || c == '\\' ) out += '\\';
+			out += c;
+		}
+		return out;
+	}
+
+	name player( size_t i ) {
+		static const char* charmap = "abcdefghijklmnopqrstuvwxyz12345";
+		char s[12] = { 'p', 'l', 'a', 'y', 'e', 'r' };
+		for( int k = 6; k < 12; ++k, i /= 31 )
+			s[k] = charmap[i % 31];
+		return name( std::string_view( s, 12 ) );
+	}
+
+	std::string json_args( size_t i, std::string& action ) {
+		std::string to = player( i ).to_string();
+		std::string qty = asset{ int64_t( i % 100000 ) * 100, gold }.to_string();
+		switch( i % 4 ) {
+			case 0:
+				action = "create";
+				return "{\"author\":\"gameauthor11\",\"category\":\"weapon\",\"owner\":\"" + to + "\",\"idata\":\"" + escape( idata ) +
+				       "\",\"mdata\":\"" + escape( mdata ) + "\",\"requireclaim\":false}";
+			case 1:
+				action = "transfer";
+				return "{\"from\":\"gametreasury\",\"to\":\"" + to + "\",\"assetids\":[" + std::to_string( 100000000000000 + i ) + "," +
+				       std::to_string( 100000000000001 + i ) + "],\"memo\":\"reward\"}";
+			case 2:
+				action = "issuef";
+				return "{\"to\":\"" + to + "\",\"author\":\"gameauthor11\",\"quantity\":\"" + qty + "\",\"memo\":\"payout\"}";
+			default:
+				action = "transferf";
+				return "{\"from\":\"gametreasury\",\"to\":\"" + to + "\",\"author\":\"gameauthor11\",\"quantity\":\"" + qty + "\",\"memo\":\"payout\"}";
+		}
+	}
+
+	template<typename F>
+	void typed_action( size_t i, F&& f ) {
+		name to = player( i );
+		asset qty{ int64_t( i % 100000 ) * 100, gold };
+		uint64_t ids[2] = { 100000000000000 + i, 100000000000001 + i };
+		switch( i % 4 ) {
+			case 0:  f( actions::create{ author, category, to, idata, mdata, false } );	break;
+			case 1:  f( actions::transfer{ treasury, to, ids, "reward" } );					break;
+			case 2:  f( actions::issuef{ to, author, qty, "payout" } );						break;
+			default: f( actions::transferf{ treasury, to, author, qty, "payout" } );		break;
+		}
+	}
+
+	template<typename F>
+	double run( const char* label, size_t count, F&& f ) {
+		auto start = std::chrono::steady_clock::now();
+		uint64_t check = f();
+		double secs = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+		printf( "%-32s %10.0f actions/s  %8.1f ns/action  (check %llu)\n", label, count / secs, secs * 1e9 / count, (unsigned long long)check );
+		return secs;
+	}
+}
+
+int main( int argc, char** argv ) {
+	size_t count = argc > 1 ? strtoull( argv[1], nullptr, 10 ) : 400000;
+	const size_t per_trx = 20;
+
+	// both paths must produce identical action data
+	for( size_t i = 0; i < 8; ++i ) {
+		std::string action;
+		std::string json = json_args( i, action );
+		writer w;
+		typed_action( i, [&]( const auto& a ) { pack( w, a ); } );
+		if ( abi_json_to_bin( action, json ) != w.data() ) {
+			fprintf( stderr, "packer and abi serializer disagree on %s\n", action.c_str() );
+			return 1;
+		}
+	}
+
+	printf( "%zu actions (create / transfer / issuef / transferf mix), %zu per transaction\n\n", count, per_trx );
+
+	double json = run( "json -> abi -> bin", count, [&] {
+		uint64_t h = 0;
+		std::string action;
+		for( size_t i = 0; i < count; ++i ) {
+			std::string json = json_args( i, action );
+			h += abi_json_to_bin( action, json ).size();
+		}
+		return h;
+	});
+
+	double typed = run( "typed pack, reused buffer", count, [&] {
+		uint64_t h = 0;
+		writer w;
+		for( size_t i = 0; i < count; ++i ) {
+			w.clear();
+			typed_action( i, [&]( const auto& a ) { pack( w, a ); } );
+			h += w.size();
+		}
+		return h;
+	});
+
+	run( "transactions + signing digest", count, [&] {
+		uint64_t h = 0;
+		transaction_builder trx;
+		checksum256 chain_id, block_id;
+		for( size_t i = 0; i < count; ) {
+			trx.begin( 1600000000, block_id );
+			for( size_t k = 0; k < per_trx && i < count; ++k, ++i )
+				typed_action( i, [&]( const auto& a ) { trx.add( contract, { { author, "active"_n } }, a ); } );
+			h += trx.signing_digest( chain_id ).hash[0];
+		}
+		return h;
+	});
+
+	printf( "\nspeedup (action packing): %.1fx\n", json / typed );
+	return 0;
+}
@@ -0,0 +1,197 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Cost model and batch splitter for actions taking vector<uint64_t> assetids
+ *  (transfer, burn, offer, canceloffer, claim, delegate, undelegate).
+ *
+ *  Per action type the model is linear in the features of a batch:
+ *    cpu_us    = base + per_asset * assets + per_byte * payload_bytes + per_nested * nested + per_author * authors
+ *    net_bytes = net_base + net_per_asset * assets
+ *  payload_bytes - idata + mdata bytes of the batch assets, nested ones included;
+ *  nested        - number of assets held in containers of the batch assets;
+ *  authors       - number of distinct authors.
+ *  Coefficients are fitted by least squares on samples from `tools/loadgen.sh calibrate`,
+ *  slopes are kept non-negative.
+ */
+
+#pragma once
+
+#include <simpleassets/decoder.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace simpleassets {
+
+	struct batch_item {
+		uint64_t	id = 0;
+		uint32_t	payload_bytes = 0;
+		uint32_t	nested = 0;
+		name		author;
+	};
+
+	/*
+	* Features of one asset row (sassets table value).
+	*/
+	inline batch_item item_from_row( const sasset_view& a ) {
+		batch_item it;
+		it.id		= a.id;
+		it.author	= a.author;
+		it.payload_bytes = a.idata.size() + a.mdata.size();
+		for( const auto& c : a.container ) {
+			batch_item n = item_from_row( c );
+			it.payload_bytes += n.payload_bytes;
+			it.nested += 1 + n.nested;
+		}
+		return it;
+	}
+
+	struct cost_sample {
+		double		cpu_us = 0;
+		double		net_bytes = 0;
+		uint32_t	assets = 0;
+		uint32_t	payload_bytes = 0;
+		uint32_t	nested = 0;
+		uint32_t	authors = 0;
+	};
+
+	struct action_cost {
+		enum { base, per_asset, per_byte, per_nested, per_author, count };
+
+		double		cpu[count]		= {};
+		double		net_base		= 0;
+		double		net_per_asset	= 0;
+		double		r2				= 0;	// fit quality of the cpu model
+		size_t		samples			= 0;
+
+		double cpu_us( uint32_t assets, uint64_t payload_bytes, uint32_t nested, uint32_t authors ) const {
+			return cpu[base] + cpu[per_asset] * assets + cpu[per_byte] * payload_bytes + cpu[per_nested] * nested + cpu[per_author] * authors;
+		}
+
+		double net_bytes( uint32_t assets ) const {
+			return net_base + net_per_asset * assets;
+		}
+	};
+
+	namespace detail {
+		/*
+		* Solves min |X b - y|^2 through the normal equations. A tiny ridge keeps features that
+		* never vary in the samples (e.g. always one author) from making the system singular.
+		*/
+		template<size_t N>
+		void least_squares( const std::vector<std::array<double, N>>& x, const std::vector<double>& y, double (&b)[N] ) {
+			double a[N][N + 1] = {};
+			for( size_t s = 0; s < x.size(); ++s ) {
+				for( size_t i = 0; i < N; ++i ) {
+					for( size_t j = 0; j < N; ++j )
+						a[i][j] += x[s][i] * x[s][j];
+					a[i][N] += x[s][i] * y[s];
+				}
+			}
+			for( size_t i = 0; i < N; ++i )
+				a[i][i] += 1e-9 * ( a[i][i] + 1 );
+
+			for( size_t c = 0; c < N; ++c ) {
+				size_t p = c;
+				for( size_t r = c + 1; r < N; ++r )
+					if ( std::fabs( a[r][c] ) > std::fabs( a[p][c] ) ) p = r;
+				std::swap( a[c], a[p] );
+				for( size_t r = 0; r < N; ++r ) {
+					if ( r == c || a[c][c] == 0 ) continue;
+					double f = a[r][c] / a[c][c];
+					for( size_t k = c; k <= N; ++k )
+						a[r][k] -= f * a[c][k];
+				}
+			}
+			for( size_t i = 0; i < N; ++i )
+				b[i] = a[i][i] == 0 ? 0 : a[i][N] / a[i][i];
+		}
+	}
+
+	inline action_cost fit( const std::vector<cost_sample>& samples ) {
+		action_cost m;
+		m.samples = samples.size();
+		if ( samples.empty() )
+			return m;
+
+		std::vector<std::array<double, action_cost::count>> x;
+		std::vector<std::array<double, 2>> xn;
+		std::vector<double> cpu, net;
+		for( const auto& s : samples ) {
+			x.push_back( { 1.0, double( s.assets ), double( s.payload_bytes ), double( s.nested ), double( s.authors ) } );
+			xn.push_back( { 1.0, double( s.assets ) } );
+			cpu.push_back( s.cpu_us );
+			net.push_back( s.net_bytes );
+		}
+		detail::least_squares( x, cpu, m.cpu );
+		for( size_t i = action_cost::per_asset; i < action_cost::count; ++i )
+			m.cpu[i] = std::max( 0.0, m.cpu[i] );		// costs never shrink when a batch grows
+
+		double n[2];
+		detail::least_squares( xn, net, n );
+		m.net_base = n[0];
+		m.net_per_asset = n[1];
+
+		double mean = 0, ss_tot = 0, ss_res = 0;
+		for( double c : cpu ) mean += c;
+		mean /= cpu.size();
+		for( const auto& s : samples ) {
+			double e = s.cpu_us - m.cpu_us( s.assets, s.payload_bytes, s.nested, s.authors );
+			ss_res += e * e;
+			ss_tot += ( s.cpu_us - mean ) * ( s.cpu_us - mean );
+		}
+		m.r2 = ss_tot > 0 ? 1 - ss_res / ss_tot : 1;
+		return m;
+	}
+
+	struct batch_limits {
+		double		cpu_us		= 150000;	// max_transaction_cpu_usage default
+		double		net_bytes	= 524288;	// max_transaction_net_usage default
+		double		margin		= 0.5;		// fraction of the limits to plan for (other load, slower producers)
+		uint32_t	max_assets	= 0;		// optional hard cap per transaction, 0 - none
+	};
+
+	/*
+	* Splits items into the fewest consecutive batches whose predicted cost fits the limits.
+	* Every batch cost only grows when an item is added, so filling each batch greedily is
+	* optimal for the given order. Items are grouped by author first (stable), which keeps
+	* the distinct-author count of each batch low. Returns the end index of every batch;
+	* a single item that alone exceeds the limits still gets its own batch.
+	*/
+	inline std::vector<size_t> split( std::vector<batch_item>& items, const action_cost& model, const batch_limits& limits,
+	                                  bool group_authors = true ) {
+		if ( group_authors )
+			std::stable_sort( items.begin(), items.end(), []( const batch_item& a, const batch_item& b ) { return a.author < b.author; } );
+
+		const double cpu_max = limits.cpu_us * limits.margin;
+		const double net_max = limits.net_bytes * limits.margin;
+
+		std::vector<size_t> ends;
+		uint32_t assets = 0, nested = 0, authors = 0;
+		uint64_t payload = 0;
+		name last_author;
+
+		for( size_t i = 0; i < items.size(); ++i ) {
+			const auto& it = items[i];
+			bool new_author = assets == 0 || it.author != last_author;		// grouped: a change is a new author
+			uint32_t a = assets + 1, n = nested + it.nested, au = authors + new_author;
+			uint64_t p = payload + it.payload_bytes;
+
+			bool fits = model.cpu_us( a, p, n, au ) <= cpu_max && model.net_bytes( a ) <= net_max &&
+			            ( limits.max_assets == 0 || a <= limits.max_assets );
+
+			if ( !fits && assets > 0 ) {
+				ends.push_back( i );
+				a = 1; n = it.nested; au = 1; p = it.payload_bytes;
+			}
+			assets = a; nested = n; authors = au; payload = p;
+			last_author = it.author;
+		}
+		if ( assets > 0 )
+			ends.push_back( items.size() );
+		return ends;
+	}
+}
@@ -0,0 +1,599 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Zero-copy decoder for SimpleAssets action payloads and table rows.
+ *
+ *  Decoders read the EOSIO binary format directly. Strings are std::string_view into the
+ *  input buffer and arrays are lazy views, so the input buffer must outlive the decoded
+ *  values. Field order mirrors the action signatures and TABLE structs in
+ *  include/SimpleAssets.hpp and must be kept in sync with them.
+ *
+ *    simpleassets::transfer_view t;
+ *    simpleassets::decode( action_data, t );    // throws simpleassets::decode_error on bad input
+ */
+
+#pragma once
+
+#include <simpleassets/types.hpp>
+#include <simpleassets/sha256.hpp>
+
+#include <type_traits>
+
+namespace simpleassets {
+
+	struct decode_error : std::runtime_error {
+		using std::runtime_error::runtime_error;
+	};
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	/*
+	* Bounds checked cursor over a serialized buffer.
+	*/
+	class reader {
+		public:
+			reader( const char* data, size_t size ) : pos( data ), end( data + size ) {}
+			explicit reader( std::string_view data ) : reader( data.data(), data.size() ) {}
+
+			size_t remaining() const { return end - pos; }
+			const char* position() const { return pos; }
+
+			void need( size_t n ) const {
+				if ( remaining() < n )
+					throw decode_error( "unexpected end of data" );
+			}
+
+			void skip( size_t n ) {
+				need( n );
+				pos += n;
+			}
+
+			template<typename T>
+			T raw() {
+				T v;
+				need( sizeof( T ) );
+				memcpy( &v, pos, sizeof( T ) );
+				pos += sizeof( T );
+				return v;
+			}
+
+			uint8_t  u8()  { return raw<uint8_t>(); }
+			uint32_t u32() { return raw<uint32_t>(); }
+			uint64_t u64() { return raw<uint64_t>(); }
+			int64_t  i64() { return raw<int64_t>(); }
+			bool     boolean() { return u8() != 0; }
+			name     nm()  { return name( u64() ); }
+
+			uint32_t varuint32() {
+				uint64_t v = 0;
+				uint8_t b;
+				uint8_t by = 0;
+				do {
+					b = u8();
+					v |= uint64_t( b & 0x7f ) << by;
+					by += 7;
+				} while( ( b & 0x80 ) && by < 35 );
+
+				if ( v > UINT32_MAX )
+					throw decode_error( "varuint32 out of range" );
+				return uint32_t( v );
+			}
+
+			std::string_view str() {
+				uint32_t n = varuint32();
+				need( n );
+				std::string_view s( pos, n );
+				pos += n;
+				return s;
+			}
+
+			asset quantity() {
+				asset a;
+				a.amount = i64();
+				a.sym = symbol( u64() );
+				return a;
+			}
+
+			checksum256 digest() {
+				checksum256 c;
+				need( 32 );
+				memcpy( c.hash, pos, 32 );
+				pos += 32;
+				return c;
+			}
+
+		private:
+			const char*	pos;
+			const char*	end;
+	};
+
+
+	// element types whose in-memory layout equals their serialized form
+	template<typename T> struct is_fixed : std::false_type {};
+	template<> struct is_fixed<uint64_t> : std::true_type {};
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	/*
+	* Lazy view over a serialized array. Elements are decoded on access with decode(reader&, T&).
+	* Elements of fixed size can be accessed by index, others only by iteration.
+	*/
+	template<typename T>
+	class array_view {
+		public:
+			array_view() {}
+			array_view( const char* data, size_t bytes, uint32_t count ) : data( data ), bytes( bytes ), count( count ) {}
+
+			uint32_t size() const { return count; }
+			bool empty() const { return count == 0; }
+			std::string_view raw() const { return { data, bytes }; }
+
+			class iterator {
+				public:
+					iterator( const char* pos, const char* end, uint32_t left ) : rd( pos, end - pos ), left( left ) { load(); }
+
+					const T& operator*() const { return cur; }
+					const T* operator->() const { return &cur; }
+					iterator& operator++() { --left; load(); return *this; }
+					bool operator==( const iterator& o ) const { return left == o.left; }
+					bool operator!=( const iterator& o ) const { return left != o.left; }
+
+				private:
+					void load() { if ( left ) decode( rd, cur ); }
+
+					reader		rd;
+					uint32_t	left;
+					T			cur;
+			};
+
+			iterator begin() const { return iterator( data, data + bytes, count ); }
+			iterator end() const { return iterator( data + bytes, data + bytes, 0 ); }
+
+			T operator[]( uint32_t i ) const {
+				static_assert( is_fixed<T>::value, "indexed access needs a fixed size element" );
+				T v;
+				memcpy( &v, data + size_t( i ) * sizeof( T ), sizeof( T ) );
+				return v;
+			}
+
+		private:
+			const char*	data	= nullptr;
+			size_t		bytes	= 0;
+			uint32_t	count	= 0;
+	};
+
+	inline void decode( reader& rd, uint64_t& v ) { v = rd.u64(); }
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	// Table rows
+
+	/*
+	* accounts table row (also used in sasset.containerf).
+	*/
+	struct account_view {
+		uint64_t	id = 0;
+		name		author;
+		asset		balance;
+	};
+
+	inline void decode( reader& rd, account_view& a ) {
+		a.id		= rd.u64();
+		a.author	= rd.nm();
+		a.balance	= rd.quantity();
+	}
+
+	template<> struct is_fixed<account_view> : std::true_type {};
+
+	/*
+	* accshards table row, key = token id * 16 + shard.
+	*/
+	struct accshard_view {
+		uint64_t	key = 0;
+		asset		balance;
+	};
+
+	inline void decode( reader& rd, accshard_view& s ) {
+		s.key		= rd.u64();
+		s.balance	= rd.quantity();
+	}
+
+	struct sasset_view;
+	inline void decode( reader& rd, sasset_view& a );
+
+	/*
+	* sassets table row. container is a view of nested sasset rows.
+	*/
+	struct sasset_view {
+		uint64_t					id = 0;
+		name						owner;
+		name						author;
+		name						category;
+		std::string_view			idata;
+		std::string_view			mdata;
+		array_view<sasset_view>		container;
+		array_view<account_view>	containerf;
+	};
+
+	namespace detail {
+		// consumes an array of T from rd and returns a view of it
+		template<typename T>
+		array_view<T> array( reader& rd ) {
+			uint32_t n = rd.varuint32();
+			const char* start = rd.position();
+
+			if ( is_fixed<T>::value ) {
+				rd.skip( size_t( n ) * sizeof( T ) );
+			} else {
+				T tmp;
+				for( uint32_t i = 0; i < n; ++i )
+					decode( rd, tmp );
+			}
+			return array_view<T>( start, rd.position() - start, n );
+		}
+	}
+
+	inline void decode( reader& rd, sasset_view& a ) {
+		a.id			= rd.u64();
+		a.owner			= rd.nm();
+		a.author		= rd.nm();
+		a.category		= rd.nm();
+		a.idata			= rd.str();
+		a.mdata			= rd.str();
+		a.container		= detail::array<sasset_view>( rd );
+		a.containerf	= detail::array<account_view>( rd );
+	}
+
+	/*
+	* stat table row (fungible token stats).
+	*/
+	struct currency_stats_view {
+		asset				supply;
+		asset				max_supply;
+		name				issuer;
+		uint64_t			id = 0;
+		bool				authorctrl = false;
+		std::string_view	data;
+	};
+
+	inline void decode( reader& rd, currency_stats_view& s ) {
+		s.supply		= rd.quantity();
+		s.max_supply	= rd.quantity();
+		s.issuer		= rd.nm();
+		s.id			= rd.u64();
+		s.authorctrl	= rd.boolean();
+		s.data			= rd.str();
+	}
+
+	/*
+	* authors table row.
+	*/
+	struct sauthor_view {
+		name				author;
+		std::string_view	data;
+		std::string_view	stemplate;
+	};
+
+	inline void decode( reader& rd, sauthor_view& a ) {
+		a.author	= rd.nm();
+		a.data		= rd.str();
+		a.stemplate	= rd.str();
+	}
+
+	/*
+	* offers table row.
+	*/
+	struct soffer_view {
+		uint64_t	assetid = 0;
+		name		owner;
+		name		offeredto;
+		uint64_t	cdate = 0;
+	};
+
+	inline void decode( reader& rd, soffer_view& o ) {
+		o.assetid	= rd.u64();
+		o.owner		= rd.nm();
+		o.offeredto	= rd.nm();
+		o.cdate		= rd.u64();
+	}
+
+	/*
+	* offerfs table row.
+	*/
+	struct sofferf_view {
+		uint64_t	id = 0;
+		name		author;
+		name		owner;
+		asset		quantity;
+		name		offeredto;
+		uint64_t	cdate = 0;
+	};
+
+	inline void decode( reader& rd, sofferf_view& o ) {
+		o.id		= rd.u64();
+		o.author	= rd.nm();
+		o.owner		= rd.nm();
+		o.quantity	= rd.quantity();
+		o.offeredto	= rd.nm();
+		o.cdate		= rd.u64();
+	}
+
+	/*
+	* delegates table row.
+	*/
+	struct sdelegate_view {
+		uint64_t	assetid = 0;
+		name		owner;
+		name		delegatedto;
+		uint64_t	cdate = 0;
+		uint64_t	period = 0;
+	};
+
+	inline void decode( reader& rd, sdelegate_view& d ) {
+		d.assetid		= rd.u64();
+		d.owner			= rd.nm();
+		d.delegatedto	= rd.nm();
+		d.cdate			= rd.u64();
+		d.period		= rd.u64();
+	}
+
+	/*
+	* events table row (event log ring buffer).
+	*/
+	struct sevent_view {
+		uint64_t				slot = 0;
+		uint64_t				seq = 0;
+		name					type;
+		name					author;
+		name					from;
+		name					to;
+		uint64_t				cdate = 0;
+		array_view<uint64_t>	assetids;
+	};
+
+	inline void decode( reader& rd, sevent_view& e ) {
+		e.slot		= rd.u64();
+		e.seq		= rd.u64();
+		e.type		= rd.nm();
+		e.author	= rd.nm();
+		e.from		= rd.nm();
+		e.to		= rd.nm();
+		e.cdate		= rd.u64();
+		e.assetids	= detail::array<uint64_t>( rd );
+	}
+
+	/*
+	* global singleton row.
+	*/
+	struct global_view {
+		uint64_t	lnftid = 0;
+		uint64_t	defid = 0;
+		uint64_t	spare1 = 0;
+		uint64_t	spare2 = 0;
+	};
+
+	inline void decode( reader& rd, global_view& g ) {
+		g.lnftid	= rd.u64();
+		g.defid		= rd.u64();
+		g.spare1	= rd.u64();
+		g.spare2	= rd.u64();
+	}
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	// Actions
+
+	struct create_view {
+		name				author;
+		name				category;
+		name				owner;
+		std::string_view	idata;
+		std::string_view	mdata;
+		bool				requireclaim = false;
+	};
+
+	inline void decode( reader& rd, create_view& a ) {
+		a.author		= rd.nm();
+		a.category		= rd.nm();
+		a.owner			= rd.nm();
+		a.idata			= rd.str();
+		a.mdata			= rd.str();
+		a.requireclaim	= rd.boolean();
+	}
+
+	struct createlog_view {
+		name				author;
+		name				category;
+		name				owner;
+		std::string_view	idata;
+		std::string_view	mdata;
+		uint64_t			assetid = 0;
+		bool				requireclaim = false;
+	};
+
+	inline void decode( reader& rd, createlog_view& a ) {
+		a.author		= rd.nm();
+		a.category		= rd.nm();
+		a.owner			= rd.nm();
+		a.idata			= rd.str();
+		a.mdata			= rd.str();
+		a.assetid		= rd.u64();
+		a.requireclaim	= rd.boolean();
+	}
+
+	// inline log of create since v1.1.0, createlog is no longer sent
+	struct createlogh_view {
+		name				author;
+		name				category;
+		name				owner;
+		uint64_t			assetid = 0;
+		bool				requireclaim = false;
+		checksum256			datahash;
+	};
+
+	inline void decode( reader& rd, createlogh_view& a ) {
+		a.author		= rd.nm();
+		a.category		= rd.nm();
+		a.owner			= rd.nm();
+		a.assetid		= rd.u64();
+		a.requireclaim	= rd.boolean();
+		a.datahash		= rd.digest();
+	}
+
+	/*
+	* createlogh.datahash of a create action: sha256 of idata and mdata as serialized in it.
+	* Match it to tell which create of a transaction a createlogh belongs to.
+	*/
+	inline checksum256 data_hash( const create_view& c ) {
+		sha256 h;
+		for( std::string_view s : { c.idata, c.mdata } ) {
+			uint8_t len[5];
+			size_t n = 0;
+			uint32_t v = uint32_t( s.size() );
+			do {
+				len[n] = uint8_t( v & 0x7f );
+				v >>= 7;
+				len[n++] |= v ? 0x80 : 0;
+			} while( v );
+			h.update( len, n ).update( s );
+		}
+		return h.final();
+	}
+
+	struct transfer_view {
+		name					from;
+		name					to;
+		array_view<uint64_t>	assetids;
+		std::string_view		memo;
+	};
+
+	inline void decode( reader& rd, transfer_view& a ) {
+		a.from		= rd.nm();
+		a.to		= rd.nm();
+		a.assetids	= detail::array<uint64_t>( rd );
+		a.memo		= rd.str();
+	}
+
+	struct claim_view {
+		name					claimer;
+		array_view<uint64_t>	assetids;
+	};
+
+	inline void decode( reader& rd, claim_view& a ) {
+		a.claimer	= rd.nm();
+		a.assetids	= detail::array<uint64_t>( rd );
+	}
+
+	struct burn_view {
+		name					owner;
+		array_view<uint64_t>	assetids;
+		std::string_view		memo;
+	};
+
+	inline void decode( reader& rd, burn_view& a ) {
+		a.owner		= rd.nm();
+		a.assetids	= detail::array<uint64_t>( rd );
+		a.memo		= rd.str();
+	}
+
+	struct transferf_view {
+		name				from;
+		name				to;
+		name				author;
+		asset				quantity;
+		std::string_view	memo;
+	};
+
+	inline void decode( reader& rd, transferf_view& a ) {
+		a.from		= rd.nm();
+		a.to		= rd.nm();
+		a.author	= rd.nm();
+		a.quantity	= rd.quantity();
+		a.memo		= rd.str();
+	}
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	// Events sent to asset authors (sae* actions)
+
+	struct saecreate_view {
+		name		owner;
+		uint64_t	assetid = 0;
+	};
+
+	inline void decode( reader& rd, saecreate_view& a ) {
+		a.owner		= rd.nm();
+		a.assetid	= rd.u64();
+	}
+
+	struct saetransfer_view {
+		name					from;
+		name					to;
+		array_view<uint64_t>	assetids;
+		std::string_view		memo;
+	};
+
+	inline void decode( reader& rd, saetransfer_view& a ) {
+		a.from		= rd.nm();
+		a.to		= rd.nm();
+		a.assetids	= detail::array<uint64_t>( rd );
+		a.memo		= rd.str();
+	}
+
+	// one entry of the saeclaim map: assetid -> previous owner
+	struct claimed_view {
+		uint64_t	assetid = 0;
+		name		from;
+	};
+
+	inline void decode( reader& rd, claimed_view& c ) {
+		c.assetid	= rd.u64();
+		c.from		= rd.nm();
+	}
+
+	template<> struct is_fixed<claimed_view> : std::true_type {};
+
+	struct saeclaim_view {
+		name						account;
+		array_view<claimed_view>	assetids;
+	};
+
+	inline void decode( reader& rd, saeclaim_view& a ) {
+		a.account	= rd.nm();
+		a.assetids	= detail::array<claimed_view>( rd );
+	}
+
+	struct saeburn_view {
+		name					account;
+		array_view<uint64_t>	assetids;
+		std::string_view		memo;
+	};
+
+	inline void decode( reader& rd, saeburn_view& a ) {
+		a.account	= rd.nm();
+		a.assetids	= detail::array<uint64_t>( rd );
+		a.memo		= rd.str();
+	}
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	/*
+	* Decodes a whole action payload or table row. Trailing bytes are rejected so that a
+	* payload decoded with the wrong type is not silently accepted.
+	*/
+	template<typename T>
+	void decode( std::string_view data, T& out ) {
+		reader rd( data );
+		decode( rd, out );
+		if ( rd.remaining() != 0 )
+			throw decode_error( "unexpected trailing data" );
+	}
+
+	template<typename T>
+	T decode( std::string_view data ) {
+		T out;
+		decode( data, out );
+		return out;
+	}
+}
@@ -0,0 +1,154 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Ownership commitment proofs. Mirrors the sparse Merkle tree the contract keeps in the
+ *  mnodes / merkle tables (see setmerkle):
+ *    depth 64, keyed by assetid, the bit of the key at depth d (1..64) is bit (64 - d);
+ *    leaf       = sha256( assetid || owner ), both uint64 little endian; empty leaf = 0;
+ *    inner node = sha256( left || right ), or 0 if both children are 0.
+ *
+ *  A proof holds the non-zero siblings on the path of one asset, from the leaf level up, and
+ *  a mask telling which levels they belong to. Asset ids are sequential, so only the lowest
+ *  ~log2(assets) siblings are non-zero and a proof is a few hundred bytes.
+ *
+ *    merkle::tree t;
+ *    t.put( assetid, owner ); ...      // e.g. all sassets rows of a saindex store
+ *    t.build();
+ *    merkle::proof p = t.prove( assetid );
+ *    bool ok = merkle::verify( root_from_chain, assetid, owner, p );
+ */
+
+#pragma once
+
+#include <simpleassets/sha256.hpp>
+
+#include <unordered_map>
+#include <vector>
+
+namespace simpleassets {
+	namespace merkle {
+
+		inline bool is_zero( const checksum256& h ) {
+			return h == checksum256();
+		}
+
+		inline checksum256 leaf( uint64_t assetid, name owner ) {
+			uint8_t data[16];
+			for( int i = 0; i < 8; ++i ) {
+				data[i] = uint8_t( assetid >> ( 8 * i ) );
+				data[8 + i] = uint8_t( owner.value >> ( 8 * i ) );
+			}
+			return sha256().update( data, sizeof( data ) ).final();
+		}
+
+		inline checksum256 node( const checksum256& left, const checksum256& right ) {
+			if ( is_zero( left ) && is_zero( right ) )
+				return checksum256();
+			return sha256().update( left.hash, 32 ).update( right.hash, 32 ).final();
+		}
+
+		struct proof {
+			uint64_t					mask = 0;		// bit i - sibling at depth 64 - i is non-zero
+			std::vector<checksum256>	siblings;		// non-zero siblings, leaf level first
+		};
+
+		/*
+		* Root of the tree in which `assetid` has leaf `h` (0 - asset not in the tree) and the
+		* other subtrees on its path are the ones in `p`. Returns 0 for a malformed proof.
+		*/
+		inline checksum256 root_from( uint64_t assetid, checksum256 h, const proof& p ) {
+			size_t k = 0;
+			for( int i = 0; i < 64; ++i ) {
+				checksum256 sib;
+				if ( p.mask >> i & 1 ) {
+					if ( k == p.siblings.size() )
+						return checksum256();
+					sib = p.siblings[k++];
+				}
+				h = ( assetid >> i & 1 ) ? node( sib, h ) : node( h, sib );
+			}
+			return k == p.siblings.size() ? h : checksum256();
+		}
+
+		/*
+		* True if `owner` held `assetid` when the tree had `root`. An empty owner checks that the
+		* asset was not in any sassets table (burned, attached or never created).
+		*/
+		inline bool verify( const checksum256& root, uint64_t assetid, name owner, const proof& p ) {
+			checksum256 h = owner.value ? leaf( assetid, owner ) : checksum256();
+			return !is_zero( root ) && root_from( assetid, h, p ) == root;
+		}
+
+
+		//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+		/*
+		* In-memory tree for proof generation. Only non-zero subtrees are kept; level d maps
+		* d bit key prefixes to subtree hashes (level 64 - leaves, level 0 - root).
+		*/
+		class tree {
+			public:
+				tree() : levels( 65 ) {}
+
+				// bulk load: put all leaves, then build() once
+				void put( uint64_t assetid, name owner ) {
+					levels[64][assetid] = leaf( assetid, owner );
+				}
+
+				void build() {
+					for( int d = 63; d >= 0; --d ) {
+						levels[d].clear();
+						for( const auto& c : levels[d + 1] ) {
+							uint64_t p = c.first >> 1;
+							if ( !levels[d].count( p ) )
+								levels[d][p] = node( get( d + 1, p << 1 ), get( d + 1, p << 1 | 1 ) );
+						}
+					}
+				}
+
+				// single update, owner empty removes the leaf
+				void set( uint64_t assetid, name owner ) {
+					assign( 64, assetid, owner.value ? leaf( assetid, owner ) : checksum256() );
+					for( int d = 63; d >= 0; --d ) {
+						uint64_t p = prefix( assetid, d );
+						assign( d, p, node( get( d + 1, p << 1 ), get( d + 1, p << 1 | 1 ) ) );
+					}
+				}
+
+				checksum256 root() const { return get( 0, 0 ); }
+
+				size_t size() const { return levels[64].size(); }
+
+				proof prove( uint64_t assetid ) const {
+					proof p;
+					for( int i = 0; i < 64; ++i ) {
+						checksum256 sib = get( 64 - i, ( assetid >> i ) ^ 1 );
+						if ( !is_zero( sib ) ) {
+							p.mask |= uint64_t( 1 ) << i;
+							p.siblings.push_back( sib );
+						}
+					}
+					return p;
+				}
+
+			private:
+				static uint64_t prefix( uint64_t key, int depth ) {
+					return depth == 0 ? 0 : key >> ( 64 - depth );
+				}
+
+				checksum256 get( int depth, uint64_t key ) const {
+					auto it = levels[depth].find( key );
+					return it == levels[depth].end() ? checksum256() : it->second;
+				}
+
+				void assign( int depth, uint64_t key, const checksum256& h ) {
+					if ( is_zero( h ) )
+						levels[depth].erase( key );
+					else
+						levels[depth][key] = h;
+				}
+
+				std::vector<std::unordered_map<uint64_t, checksum256>> levels;
+		};
+	}
+}
@@ -0,0 +1,459 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Client side packing of SimpleAssets actions and whole transactions, for minting and payout bots.
+ *
+ *  Action structs mirror the ACTION signatures in SimpleAssets.hpp field by field (same names,
+ *  same order) and are packed straight into reusable buffers: once the buffers have grown to
+ *  their working size, packing an action or a transaction does not allocate.
+ *
+ *    transaction_builder trx;
+ *    trx.begin( expiration, ref_block_id );
+ *    trx.add( "simpleassets"_n, { author, "active"_n }, actions::create{ author, category, owner, idata, mdata, false } );
+ *    std::string_view packed = trx.packed();
+ *    checksum256 digest = trx.signing_digest( chain_id );
+ */
+
+#pragma once
+
+#include <simpleassets/sha256.hpp>
+
+#include <initializer_list>
+#include <vector>
+
+namespace simpleassets {
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	/*
+	* Appends EOSIO wire format values to a std::string. clear() keeps the capacity.
+	*/
+	class writer {
+		public:
+			void clear() { buf.clear(); }
+			void reserve( size_t n ) { buf.reserve( n ); }
+			void resize( size_t n ) { buf.resize( n ); }
+
+			size_t size() const { return buf.size(); }
+			std::string_view data() const { return buf; }
+
+			void put( const void* data, size_t size ) { buf.append( (const char*)data, size ); }
+
+			template<typename T>
+			void raw( T v ) { put( &v, sizeof( T ) ); }
+
+			void u8( uint8_t v )		{ raw( v ); }
+			void u16( uint16_t v )		{ raw( v ); }
+			void u32( uint32_t v )		{ raw( v ); }
+			void u64( uint64_t v )		{ raw( v ); }
+			void boolean( bool v )		{ raw<uint8_t>( v ); }
+			void nm( name v )			{ raw( v.value ); }
+			void sym( symbol v )		{ raw( v.value ); }
+
+			void quantity( const asset& v ) {
+				raw( v.amount );
+				raw( v.sym.value );
+			}
+
+			void varuint32( uint32_t v ) {
+				do {
+					uint8_t b = v & 0x7f;
+					v >>= 7;
+					buf += char( b | ( v ? 0x80 : 0 ) );
+				} while( v );
+			}
+
+			void str( std::string_view s ) {
+				varuint32( s.size() );
+				buf.append( s );
+			}
+
+		private:
+			std::string buf;
+	};
+
+	/*
+	* Non-owning list of asset / offer ids (vector<uint64_t> action parameters).
+	*/
+	struct id_list {
+		const uint64_t*	ids		= nullptr;
+		size_t			count	= 0;
+
+		id_list() {}
+		id_list( const uint64_t* ids, size_t count ) : ids( ids ), count( count ) {}
+		id_list( const std::vector<uint64_t>& v ) : ids( v.data() ), count( v.size() ) {}
+		template<size_t N>
+		id_list( const uint64_t (&a)[N] ) : ids( a ), count( N ) {}
+	};
+
+	inline void pack( writer& w, id_list v ) {
+		w.varuint32( v.count );
+		w.put( v.ids, v.count * sizeof( uint64_t ) );
+	}
+
+	/*
+	* Asset ids packed as {first, count} runs of sequential ids (vector<idrange> action parameters
+	* of transferr, burnr, ...). The runs are found while packing, ids are taken in the given order.
+	*/
+	struct range_list {
+		id_list		ids;
+
+		range_list() {}
+		range_list( id_list ids ) : ids( ids ) {}
+		range_list( const std::vector<uint64_t>& v ) : ids( v ) {}
+	};
+
+	inline void pack( writer& w, range_list v ) {
+		const uint64_t* ids = v.ids.ids;
+		size_t n = v.ids.count;
+
+		uint32_t runs = 0;
+		for( size_t i = 0; i < n; ++i )
+			runs += i == 0 || ids[i] != ids[i - 1] + 1;
+		w.varuint32( runs );
+
+		for( size_t i = 0; i < n; ) {
+			size_t j = i + 1;
+			while( j < n && ids[j] == ids[j - 1] + 1 )
+				++j;
+			w.u64( ids[i] );
+			w.u32( uint32_t( j - i ) );
+			i = j;
+		}
+	}
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	/*
+	* Action payloads. Strings are views, the caller keeps them alive until packed.
+	*/
+	namespace actions {
+
+		struct create {
+			inline static const name action{ "create" };
+			name				author;
+			name				category;
+			name				owner;
+			std::string_view	idata;
+			std::string_view	mdata;
+			bool				requireclaim = false;
+		};
+
+		struct claim {
+			inline static const name action{ "claim" };
+			name				claimer;
+			id_list				assetids;
+		};
+
+		struct transfer {
+			inline static const name action{ "transfer" };
+			name				from;
+			name				to;
+			id_list				assetids;
+			std::string_view	memo;
+		};
+
+		struct update {
+			inline static const name action{ "update" };
+			name				author;
+			name				owner;
+			uint64_t			assetid = 0;
+			std::string_view	mdata;
+		};
+
+		struct offer {
+			inline static const name action{ "offer" };
+			name				owner;
+			name				newowner;
+			id_list				assetids;
+			std::string_view	memo;
+		};
+
+		struct burn {
+			inline static const name action{ "burn" };
+			name				owner;
+			id_list				assetids;
+			std::string_view	memo;
+		};
+
+		struct transferall {
+			inline static const name action{ "transferall" };
+			name				from;
+			name				to;
+			name				author;
+			name				category;
+			uint64_t			cursor = 0;
+			uint32_t			limit = 0;
+			std::string_view	memo;
+		};
+
+		struct burnall {
+			inline static const name action{ "burnall" };
+			name				owner;
+			name				author;
+			name				category;
+			uint64_t			cursor = 0;
+			uint32_t			limit = 0;
+			std::string_view	memo;
+		};
+
+		struct delegate {
+			inline static const name action{ "delegate" };
+			name				owner;
+			name				to;
+			id_list				assetids;
+			uint64_t			period = 0;
+			std::string_view	memo;
+		};
+
+		// range variants, same fields with the assets as runs of sequential ids
+		struct claimr {
+			inline static const name action{ "claimr" };
+			name				claimer;
+			range_list			ranges;
+		};
+
+		struct transferr {
+			inline static const name action{ "transferr" };
+			name				from;
+			name				to;
+			range_list			ranges;
+			std::string_view	memo;
+		};
+
+		struct offerr {
+			inline static const name action{ "offerr" };
+			name				owner;
+			name				newowner;
+			range_list			ranges;
+			std::string_view	memo;
+		};
+
+		struct burnr {
+			inline static const name action{ "burnr" };
+			name				owner;
+			range_list			ranges;
+			std::string_view	memo;
+		};
+
+		struct delegater {
+			inline static const name action{ "delegater" };
+			name				owner;
+			name				to;
+			range_list			ranges;
+			uint64_t			period = 0;
+			std::string_view	memo;
+		};
+
+		struct createf {
+			inline static const name action{ "createf" };
+			name				author;
+			asset				maximum_supply;
+			bool				authorctrl = false;
+			std::string_view	data;
+		};
+
+		struct issuef {
+			inline static const name action{ "issuef" };
+			name				to;
+			name				author;
+			asset				quantity;
+			std::string_view	memo;
+		};
+
+		struct transferf {
+			inline static const name action{ "transferf" };
+			name				from;
+			name				to;
+			name				author;
+			asset				quantity;
+			std::string_view	memo;
+		};
+
+		struct offerf {
+			inline static const name action{ "offerf" };
+			name				owner;
+			name				newowner;
+			name				author;
+			asset				quantity;
+			std::string_view	memo;
+		};
+
+		struct burnf {
+			inline static const name action{ "burnf" };
+			name				from;
+			name				author;
+			asset				quantity;
+			std::string_view	memo;
+		};
+	}
+
+	inline void pack( writer& w, const actions::create& a ) {
+		w.nm( a.author ); w.nm( a.category ); w.nm( a.owner ); w.str( a.idata ); w.str( a.mdata ); w.boolean( a.requireclaim );
+	}
+
+	inline void pack( writer& w, const actions::claim& a ) {
+		w.nm( a.claimer ); pack( w, a.assetids );
+	}
+
+	inline void pack( writer& w, const actions::transfer& a ) {
+		w.nm( a.from ); w.nm( a.to ); pack( w, a.assetids ); w.str( a.memo );
+	}
+
+	inline void pack( writer& w, const actions::update& a ) {
+		w.nm( a.author ); w.nm( a.owner ); w.u64( a.assetid ); w.str( a.mdata );
+	}
+
+	inline void pack( writer& w, const actions::offer& a ) {
+		w.nm( a.owner ); w.nm( a.newowner ); pack( w, a.assetids ); w.str( a.memo );
+	}
+
+	inline void pack( writer& w, const actions::burn& a ) {
+		w.nm( a.owner ); pack( w, a.assetids ); w.str( a.memo );
+	}
+
+	inline void pack( writer& w, const actions::transferall& a ) {
+		w.nm( a.from ); w.nm( a.to ); w.nm( a.author ); w.nm( a.category ); w.u64( a.cursor ); w.u32( a.limit ); w.str( a.memo );
+	}
+
+	inline void pack( writer& w, const actions::burnall& a ) {
+		w.nm( a.owner ); w.nm( a.author ); w.nm( a.category ); w.u64( a.cursor ); w.u32( a.limit ); w.str( a.memo );
+	}
+
+	inline void pack( writer& w, const actions::delegate& a ) {
+		w.nm( a.owner ); w.nm( a.to ); pack( w, a.assetids ); w.u64( a.period ); w.str( a.memo );
+	}
+
+	inline void pack( writer& w, const actions::claimr& a ) {
+		w.nm( a.claimer ); pack( w, a.ranges );
+	}
+
+	inline void pack( writer& w, const actions::transferr& a ) {
+		w.nm( a.from ); w.nm( a.to ); pack( w, a.ranges ); w.str( a.memo );
+	}
+
+	inline void pack( writer& w, const actions::offerr& a ) {
+		w.nm( a.owner ); w.nm( a.newowner ); pack( w, a.ranges ); w.str( a.memo );
+	}
+
+	inline void pack( writer& w, const actions::burnr& a ) {
+		w.nm( a.owner ); pack( w, a.ranges ); w.str( a.memo );
+	}
+
+	inline void pack( writer& w, const actions::delegater& a ) {
+		w.nm( a.owner ); w.nm( a.to ); pack( w, a.ranges ); w.u64( a.period ); w.str( a.memo );
+	}
+
+	inline void pack( writer& w, const actions::createf& a ) {
+		w.nm( a.author ); w.quantity( a.maximum_supply ); w.boolean( a.authorctrl ); w.str( a.data );
+	}
+
+	inline void pack( writer& w, const actions::issuef& a ) {
+		w.nm( a.to ); w.nm( a.author ); w.quantity( a.quantity ); w.str( a.memo );
+	}
+
+	inline void pack( writer& w, const actions::transferf& a ) {
+		w.nm( a.from ); w.nm( a.to ); w.nm( a.author ); w.quantity( a.quantity ); w.str( a.memo );
+	}
+
+	inline void pack( writer& w, const actions::offerf& a ) {
+		w.nm( a.owner ); w.nm( a.newowner ); w.nm( a.author ); w.quantity( a.quantity ); w.str( a.memo );
+	}
+
+	inline void pack( writer& w, const actions::burnf& a ) {
+		w.nm( a.from ); w.nm( a.author ); w.quantity( a.quantity ); w.str( a.memo );
+	}
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	struct permission_level {
+		name	actor;
+		name	permission;
+	};
+
+	/*
+	* Builds one packed transaction (no context free actions, no extensions). Reuse the builder:
+	* begin() resets it while keeping all buffer capacity.
+	*/
+	class transaction_builder {
+		public:
+			/*
+			* expiration - unix time (seconds); ref_block_id - id of a recent (preferably irreversible) block.
+			*/
+			transaction_builder& begin( uint32_t expiration, const checksum256& ref_block_id,
+			                            uint32_t max_net_usage_words = 0, uint8_t max_cpu_usage_ms = 0, uint32_t delay_sec = 0 ) {
+				uint32_t prefix;
+				memcpy( &prefix, ref_block_id.hash + 8, 4 );
+				uint16_t num = uint16_t( ref_block_id.hash[2] ) << 8 | ref_block_id.hash[3];
+				return begin( expiration, num, prefix, max_net_usage_words, max_cpu_usage_ms, delay_sec );
+			}
+
+			transaction_builder& begin( uint32_t expiration, uint16_t ref_block_num, uint32_t ref_block_prefix,
+			                            uint32_t max_net_usage_words = 0, uint8_t max_cpu_usage_ms = 0, uint32_t delay_sec = 0 ) {
+				trx.clear();
+				trx.u32( expiration );
+				trx.u16( ref_block_num );
+				trx.u32( ref_block_prefix );
+				trx.varuint32( max_net_usage_words );
+				trx.u8( max_cpu_usage_ms );
+				trx.varuint32( delay_sec );
+				trx.varuint32( 0 );		// context_free_actions
+				header = trx.size();
+
+				body.clear();
+				count = 0;
+				return *this;
+			}
+
+			template<typename A>
+			transaction_builder& add( name contract, std::initializer_list<permission_level> auth, const A& action ) {
+				body.nm( contract );
+				body.nm( A::action );
+				body.varuint32( auth.size() );
+				for( const auto& p : auth ) {
+					body.nm( p.actor );
+					body.nm( p.permission );
+				}
+
+				data.clear();
+				pack( data, action );
+				body.str( data.data() );
+
+				++count;
+				return *this;
+			}
+
+			size_t actions() const { return count; }
+
+			// serialized transaction (packed_trx)
+			std::string_view packed() {
+				trx.resize( header );
+				trx.varuint32( count );
+				trx.put( body.data().data(), body.size() );
+				trx.varuint32( 0 );		// transaction_extensions
+				return trx.data();
+			}
+
+			// transaction id
+			checksum256 id() {
+				return sha256::hash( packed() );
+			}
+
+			// digest to sign: sha256( chain_id | packed_trx | sha256 of context free data, zero when empty )
+			checksum256 signing_digest( const checksum256& chain_id ) {
+				static const uint8_t no_cfd[32] = {};
+				std::string_view p = packed();
+				hasher.reset();
+				hasher.update( chain_id.hash, 32 ).update( p ).update( no_cfd, 32 );
+				return hasher.final();
+			}
+
+		private:
+			writer		trx;
+			writer		body;
+			writer		data;
+			size_t		header	= 0;
+			size_t		count	= 0;
+			sha256		hasher;
+	};
+}
@@ -0,0 +1,246 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Symbolization of CPU profiles of the contract's wasm code (see tools/saprof.cpp).
+ *
+ *  Profiles are in the gperftools legacy CPU profile format, as written by nodeos'
+ *  --profile-account (eos-vm-jit) for one contract, 64-bit little endian words:
+ *    header:  0 | 3 | 0 | sampling period (usec) | 0
+ *    sample:  count | depth | pc[depth]            (pc[0] - innermost frame)
+ *    trailer: 0 | 1 | 0                            (followed by a text memory map, ignored)
+ *  A pc is a byte offset into the wasm module (or into the code section, see `code_relative`);
+ *  a pc outside every function body is host code, i.e. an intrinsic called by the contract.
+ *
+ *  Function names come from the module's `name` custom section; without it (stripped builds)
+ *  functions are called func[index].
+ *
+ *    auto m = wasmprof::load_module( wasm );
+ *    auto p = wasmprof::load_profile( data );
+ *    for( const auto& s : p.samples )
+ *        auto stack = m.frames( s, false );        // outermost first
+ */
+
+#pragma once
+
+#include <simpleassets/decoder.hpp>
+
+#include <algorithm>
+#include <cxxabi.h>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace simpleassets::wasmprof {
+
+	struct function {
+		uint32_t	index = 0;		// function index space (imports first)
+		uint32_t	begin = 0;		// body, module byte offsets [begin, end)
+		uint32_t	end = 0;
+		std::string	name;
+	};
+
+	struct sample {
+		uint64_t				count = 0;
+		std::vector<uint64_t>	pcs;		// innermost frame first
+	};
+
+	struct profile {
+		uint64_t			period_usec = 0;
+		std::vector<sample>	samples;
+
+		uint64_t total() const {
+			uint64_t n = 0;
+			for( const auto& s : samples )
+				n += s.count;
+			return n;
+		}
+	};
+
+
+	// C++ names are demangled, other names are kept
+	inline std::string demangle( const std::string& name ) {
+		int status = 0;
+		char* d = abi::__cxa_demangle( name.c_str(), nullptr, nullptr, &status );
+		if ( status != 0 || !d )
+			return name;
+		std::string res( d );
+		free( d );
+		return res;
+	}
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	class module {
+		public:
+			std::vector<std::string>	imports;		// host functions, by function index
+			std::vector<function>		functions;		// defined functions, by body offset
+			uint32_t					code_offset = 0;	// module offset of the code section payload
+			std::string_view			bytes;
+
+			// function whose body holds module offset `pc`, nullptr for host code
+			const function* at( uint64_t pc ) const {
+				auto it = std::upper_bound( functions.begin(), functions.end(), pc,
+					[]( uint64_t p, const function& f ) { return p < f.begin; } );
+				if ( it == functions.begin() || pc >= ( --it )->end )
+					return nullptr;
+				return &*it;
+			}
+
+			/*
+			* Frame names of a sample, outermost first. Return addresses (all but the innermost pc)
+			* are moved back into their call instruction. If the innermost pc is host code, the
+			* intrinsic is taken from the call instruction of the frame below it when that decodes
+			* to a call of an import.
+			*/
+			std::vector<std::string> frames( const sample& s, bool code_relative ) const {
+				std::vector<std::string> res;
+				uint64_t base = code_relative ? code_offset : 0;
+
+				for( size_t i = s.pcs.size(); i-- > 0; ) {
+					uint64_t pc = s.pcs[i] + base;
+					if ( i > 0 && pc > 0 )
+						--pc;
+					if ( const function* f = at( pc ) ) {
+						res.push_back( f->name );
+						continue;
+					}
+					if ( i == 0 ) {
+						std::string host = "[host]";
+						if ( s.pcs.size() > 1 && at( s.pcs[1] + base - 1 ) )
+							host = "[host] " + called_import( s.pcs[1] + base );
+						res.push_back( host );
+					}
+					// other unmapped frames: interpreter or host glue between wasm frames, skipped
+				}
+				return res;
+			}
+
+		private:
+			// import called by the `call` instruction that ends at module offset `ret`, or "" if none
+			std::string called_import( uint64_t ret ) const {
+				for( uint64_t start = ret >= 6 ? ret - 6 : 0; start + 1 < ret; ++start ) {
+					if ( uint8_t( bytes[start] ) != 0x10 )		// call
+						continue;
+					uint64_t idx = 0, shift = 0, p = start + 1;
+					for( ; p < ret && shift < 35; ++p, shift += 7 ) {
+						idx |= uint64_t( bytes[p] & 0x7f ) << shift;
+						if ( !( bytes[p] & 0x80 ) )
+							break;
+					}
+					if ( p + 1 == ret && idx < imports.size() )
+						return imports[idx];
+				}
+				return "";
+			}
+	};
+
+
+	/*
+	* Reads the import, code and name sections of a wasm module. `wasm` must outlive the module.
+	*/
+	inline module load_module( std::string_view wasm ) {
+		module m;
+		m.bytes = wasm;
+
+		reader rd( wasm );
+		if ( rd.u32() != 0x6d736100 )		// "\0asm"
+			throw decode_error( "not a wasm module" );
+		rd.u32();	// version
+
+		std::map<uint32_t, std::string> names;
+		while( rd.remaining() ) {
+			uint8_t id = rd.u8();
+			uint32_t size = rd.varuint32();
+			rd.need( size );
+			reader sec( rd.position(), size );
+			uint32_t offset = uint32_t( rd.position() - wasm.data() );
+			rd.skip( size );
+
+			if ( id == 2 ) {			// import
+				for( uint32_t n = sec.varuint32(); n > 0; --n ) {
+					sec.str();		// module
+					std::string field( sec.str() );
+					uint8_t kind = sec.u8();
+					if ( kind == 0 ) {			// function: type index
+						sec.varuint32();
+						m.imports.push_back( field );
+					} else if ( kind == 1 ) {	// table: elem type, limits
+						sec.u8();
+						if ( sec.varuint32() & 1 ) sec.varuint32();
+						sec.varuint32();
+					} else if ( kind == 2 ) {	// memory: limits
+						if ( sec.varuint32() & 1 ) sec.varuint32();
+						sec.varuint32();
+					} else {					// global: value type, mutability
+						sec.u8();
+						sec.u8();
+					}
+				}
+			} else if ( id == 10 ) {	// code
+				m.code_offset = offset;
+				uint32_t n = sec.varuint32();
+				for( uint32_t i = 0; i < n; ++i ) {
+					uint32_t body = sec.varuint32();
+					function f;
+					f.index = uint32_t( m.imports.size() ) + i;
+					f.begin = uint32_t( sec.position() - wasm.data() );
+					f.end = f.begin + body;
+					sec.skip( body );
+					m.functions.push_back( f );
+				}
+			} else if ( id == 0 && sec.str() == "name" ) {
+				while( sec.remaining() ) {
+					uint8_t sub = sec.u8();
+					uint32_t subsize = sec.varuint32();
+					sec.need( subsize );
+					reader ss( sec.position(), subsize );
+					sec.skip( subsize );
+					if ( sub != 1 )		// function names
+						continue;
+					for( uint32_t n = ss.varuint32(); n > 0; --n ) {
+						uint32_t idx = ss.varuint32();
+						names[idx] = demangle( std::string( ss.str() ) );
+					}
+				}
+			}
+		}
+
+		for( auto& f : m.functions ) {
+			auto it = names.find( f.index );
+			f.name = it != names.end() ? it->second : "func[" + std::to_string( f.index ) + "]";
+		}
+		for( uint32_t i = 0; i < m.imports.size(); ++i ) {
+			auto it = names.find( i );
+			if ( it != names.end() )
+				m.imports[i] = it->second;
+		}
+		return m;
+	}
+
+
+	inline profile load_profile( std::string_view data ) {
+		profile p;
+		reader rd( data );
+		if ( rd.u64() != 0 || rd.u64() != 3 || rd.u64() != 0 )
+			throw decode_error( "not a 64-bit gperftools CPU profile" );
+		p.period_usec = rd.u64();
+		rd.u64();
+
+		while( rd.remaining() ) {
+			sample s;
+			s.count = rd.u64();
+			uint64_t depth = rd.u64();
+			if ( s.count == 0 && depth == 1 ) {		// trailer
+				rd.u64();
+				break;
+			}
+			rd.need( depth * 8 );
+			for( uint64_t i = 0; i < depth; ++i )
+				s.pcs.push_back( rd.u64() );
+			p.samples.push_back( std::move( s ) );
+		}
+		return p;
+	}
+}
@@ -0,0 +1,126 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Minimal state-history (SHiP) protocol reader: enough of the `result` variant to walk
+ *  get_blocks_result_v0 messages and the contract_row table deltas inside them.
+ *  Types follow the state_history_plugin ABI (table_delta_v0, row, contract_row_v0).
+ */
+
+#pragma once
+
+#include <simpleassets/decoder.hpp>
+
+#include <optional>
+#include <vector>
+
+namespace simpleassets::ship {
+
+	struct block_position {
+		uint32_t	block_num = 0;
+		checksum256	block_id;
+	};
+
+	/*
+	* get_blocks_result_v0. Optional binary members are views into the message.
+	*/
+	struct get_blocks_result {
+		block_position					head;
+		block_position					last_irreversible;
+		std::optional<block_position>	this_block;
+		std::optional<block_position>	prev_block;
+		std::optional<std::string_view>	block;
+		std::optional<std::string_view>	traces;
+		std::optional<std::string_view>	deltas;
+	};
+
+	/*
+	* One contract_row_v0 change. present == false means the row was removed.
+	*/
+	struct contract_row {
+		bool				present = false;
+		name				code;
+		name				scope;
+		name				table;
+		uint64_t			primary_key = 0;
+		name				payer;
+		std::string_view	value;
+	};
+
+	inline block_position read_position( reader& rd ) {
+		block_position p;
+		p.block_num	= rd.u32();
+		p.block_id	= rd.digest();
+		return p;
+	}
+
+	template<typename T, typename F>
+	std::optional<T> read_optional( reader& rd, F&& f ) {
+		if ( !rd.boolean() )
+			return std::nullopt;
+		return f( rd );
+	}
+
+	/*
+	* Parses one `result` message. Returns false for anything but get_blocks_result_v0
+	* (for example the get_status_result_v0 sent after connecting).
+	*/
+	inline bool parse_result( std::string_view msg, get_blocks_result& res ) {
+		reader rd( msg );
+		if ( rd.varuint32() != 1 )
+			return false;
+
+		auto bytes = []( reader& r ) { return r.str(); };
+
+		res.head				= read_position( rd );
+		res.last_irreversible	= read_position( rd );
+		res.this_block			= read_optional<block_position>( rd, read_position );
+		res.prev_block			= read_optional<block_position>( rd, read_position );
+		res.block				= read_optional<std::string_view>( rd, bytes );
+		res.traces				= read_optional<std::string_view>( rd, bytes );
+		res.deltas				= read_optional<std::string_view>( rd, bytes );
+		return true;
+	}
+
+	/*
+	* Calls f(const contract_row&) for every contract_row delta of `code` in a serialized
+	* vector<table_delta>. Other tables (accounts, permissions, resources...) are skipped.
+	*/
+	template<typename F>
+	void for_each_contract_row( std::string_view deltas, name code, F&& f ) {
+		reader rd( deltas );
+		uint32_t tables = rd.varuint32();
+
+		for( uint32_t t = 0; t < tables; ++t ) {
+			if ( rd.varuint32() != 0 )
+				throw decode_error( "unsupported table_delta version" );
+
+			std::string_view table = rd.str();
+			uint32_t rows = rd.varuint32();
+			bool contract_rows = table == "contract_row";
+
+			for( uint32_t r = 0; r < rows; ++r ) {
+				contract_row row;
+				row.present = rd.boolean();
+				std::string_view data = rd.str();
+				if ( !contract_rows )
+					continue;
+
+				reader rr( data );
+				if ( rr.varuint32() != 0 )
+					throw decode_error( "unsupported contract_row version" );
+
+				row.code = rr.nm();
+				if ( row.code != code )
+					continue;
+
+				row.scope		= rr.nm();
+				row.table		= rr.nm();
+				row.primary_key	= rr.u64();
+				row.payer		= rr.nm();
+				row.value		= rr.str();
+				f( row );
+			}
+		}
+	}
+}
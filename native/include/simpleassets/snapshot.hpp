@@ -0,0 +1,129 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Reader for binary nodeos snapshots (portable snapshot format, chain snapshot version 2+).
+ *
+ *  File layout (little endian):
+ *    uint32 magic 0x30510550 | uint32 version
+ *    section: uint64 size | uint64 row_count | name '\0' | rows      (size counts everything after itself)
+ *    end:     uint64 0xffffffffffffffff
+ *
+ *  The "contract_tables" section holds, for every table, a table_id_object row
+ *  (code, scope, table, payer, uint32 count) followed by six row groups, each a varuint32
+ *  size and the rows: key_value (primary_key, payer, bytes value), then index64, index128,
+ *  index256, index_double and index_long_double (primary_key, payer, fixed size key).
+ */
+
+#pragma once
+
+#include <simpleassets/decoder.hpp>
+
+namespace simpleassets::snapshot {
+
+	const uint32_t magic		= 0x30510550;
+	const uint64_t end_marker	= ~uint64_t( 0 );
+
+	struct section {
+		std::string_view	name;
+		uint64_t			rows = 0;
+		std::string_view	data;		// row data, after the name
+	};
+
+	/*
+	* One contract table. rows holds `count` serialized key_value rows.
+	*/
+	struct table {
+		name				code;
+		name				scope;
+		name				table;
+		name				payer;
+		uint32_t			count = 0;	// key_value rows
+		std::string_view	rows;
+	};
+
+	/*
+	* Calls f(const section&) for every section of the snapshot in file order.
+	*/
+	template<typename F>
+	void for_each_section( std::string_view file, F&& f ) {
+		reader rd( file );
+		if ( rd.u32() != magic )
+			throw decode_error( "not a binary snapshot" );
+		rd.u32();	// snapshot file version
+
+		for(;;) {
+			uint64_t size = rd.u64();
+			if ( size == end_marker )
+				return;
+			rd.need( size );
+
+			reader sr( rd.position(), size );
+			rd.skip( size );
+
+			section s;
+			s.rows = sr.u64();
+			const char* start = sr.position();
+			while( sr.u8() != 0 ) {}
+			s.name = std::string_view( start, sr.position() - start - 1 );
+			s.data = std::string_view( sr.position(), sr.remaining() );
+			f( s );
+		}
+	}
+
+	/*
+	* Walks a "contract_tables" section and calls f(const table&) for every table of `code`.
+	* Tables of other contracts are skipped without decoding their values.
+	*/
+	template<typename F>
+	void for_each_table( std::string_view contract_tables, name code, F&& f ) {
+		// primary_key + payer + secondary key, for index64 .. index_long_double
+		static const size_t secondary_row[] = { 24, 32, 48, 24, 32 };
+
+		reader rd( contract_tables );
+		while( rd.remaining() ) {
+			table t;
+			t.code	= rd.nm();
+			t.scope	= rd.nm();
+			t.table	= rd.nm();
+			t.payer	= rd.nm();
+			rd.u32();	// rows over all indexes
+
+			t.count = rd.varuint32();
+			const char* start = rd.position();
+			for( uint32_t i = 0; i < t.count; ++i ) {
+				rd.skip( 16 );
+				rd.str();
+			}
+			t.rows = std::string_view( start, rd.position() - start );
+
+			for( size_t row_size : secondary_row )
+				rd.skip( size_t( rd.varuint32() ) * row_size );
+
+			if ( t.code == code )
+				f( t );
+		}
+	}
+
+	/*
+	* Calls f(uint64_t primary_key, name payer, std::string_view value) for every row of a table.
+	*/
+	template<typename F>
+	void for_each_row( const table& t, F&& f ) {
+		reader rd( t.rows );
+		for( uint32_t i = 0; i < t.count; ++i ) {
+			uint64_t pk = rd.u64();
+			name payer = rd.nm();
+			f( pk, payer, rd.str() );
+		}
+	}
+
+	/*
+	* Block number of the snapshot, from the first row of the "eosio::chain::block_state" section
+	* (block_header_state starts with block_num).
+	*/
+	inline uint32_t block_num( const section& block_state ) {
+		reader rd( block_state.data );
+		return rd.u32();
+	}
+}
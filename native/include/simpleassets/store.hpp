@@ -0,0 +1,140 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Local materialized copy of the SimpleAssets tables (sassets, offers, offerfs, delegates,
+ *  accounts, stat, authors, global, offersto, offerfsto, accshards) with by-owner, by-author
+ *  and by-category indexes.
+ *
+ *  On disk the store is one compact file, loaded with mmap: row values stay in the mapping
+ *  and only rows changed since the last checkpoint are held in memory. checkpoint() writes
+ *  a new file next to the old one and atomically replaces it.
+ *
+ *  File format (little endian):
+ *    header: "SASTORE1" | uint32 version | uint32 last_block | uint64 rows
+ *    row:    uint8 table | uint64 scope | uint64 primary_key | uint64 payer | varuint32 size | value
+ */
+
+#pragma once
+
+#include <simpleassets/decoder.hpp>
+
+#include <deque>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace simpleassets {
+
+	enum class table_id : uint8_t {
+		sassets, offers, offerfs, delegates, accounts, stat, authors, global, offersto, offerfsto, accshards, count
+	};
+
+	// maps a contract table name to its table_id (offersown, offerfsown and delegatesto to offers, offerfs
+	// and delegates), returns false for other tables. New ids go before count: they are stored in files.
+	bool table_from_name( name table, table_id& id );
+	name table_name( table_id id );
+
+
+	struct row {
+		name				payer;
+		std::string_view	value;
+	};
+
+	class store {
+		public:
+			explicit store( std::string path );
+			~store();
+
+			store( const store& ) = delete;
+			store& operator=( const store& ) = delete;
+
+			uint32_t last_block() const { return lastblock; }
+			void set_last_block( uint32_t block ) { lastblock = block; }
+
+			size_t size() const { return rows.size(); }
+			size_t size( table_id table ) const;
+
+			// value is copied
+			void upsert( table_id table, name scope, uint64_t primary_key, name payer, std::string_view value );
+			void remove( table_id table, name scope, uint64_t primary_key );
+
+			const row* get( table_id table, name scope, uint64_t primary_key ) const;
+
+			/*
+			* Index walks. f( name scope, uint64_t primary_key, const row& ) is called for every
+			* row of `table` whose owner / author / category is `key`:
+			*   owner    - sassets, accounts and accshards scope, offers, offerfs and delegates owner
+			*              field, offersto and offerfsto scope (the recipient);
+			*   author   - sassets, offerfs, offerfsto, accounts and authors author field, stat scope;
+			*   category - sassets category.
+			*/
+			template<typename F> void by_owner( table_id table, name key, F&& f ) const { walk( owners, table, key, f ); }
+			template<typename F> void by_author( table_id table, name key, F&& f ) const { walk( authors, table, key, f ); }
+			template<typename F> void by_category( table_id table, name key, F&& f ) const { walk( categories, table, key, f ); }
+
+			// f( name scope, uint64_t primary_key, const row& ) for every row of `table`, in no particular order
+			template<typename F>
+			void for_each( table_id table, F&& f ) const {
+				for( const auto& r : rows )
+					if ( r.first.table == uint8_t( table ) )
+						f( name( r.first.scope ), r.first.pk, r.second );
+			}
+
+			// writes all rows to a new compact file, replaces the old one and releases changed-row memory
+			void checkpoint();
+
+		private:
+			struct row_key {
+				uint8_t		table;
+				uint64_t	scope;
+				uint64_t	pk;
+
+				bool operator==( const row_key& o ) const { return table == o.table && scope == o.scope && pk == o.pk; }
+			};
+
+			struct row_key_hash {
+				size_t operator()( const row_key& k ) const {
+					return std::hash<uint64_t>()( k.pk * 0x9e3779b97f4a7c15ull ^ k.scope ^ ( uint64_t( k.table ) << 56 ) );
+				}
+			};
+
+			struct index_entry {
+				uint8_t		table;
+				uint64_t	key;
+				uint64_t	scope;
+				uint64_t	pk;
+
+				bool operator<( const index_entry& o ) const {
+					return std::tie( table, key, scope, pk ) < std::tie( o.table, o.key, o.scope, o.pk );
+				}
+			};
+
+			using index = std::set<index_entry>;
+
+			template<typename F>
+			void walk( const index& idx, table_id table, name key, F& f ) const {
+				uint8_t t = uint8_t( table );
+				for( auto it = idx.lower_bound( { t, key.value, 0, 0 } ); it != idx.end() && it->table == t && it->key == key.value; ++it ) {
+					auto r = rows.find( { t, it->scope, it->pk } );
+					f( name( it->scope ), it->pk, r->second );
+				}
+			}
+
+			void index_row( const row_key& k, std::string_view value, bool add );
+			void load();
+			void unmap();
+
+			std::string										path;
+			uint32_t										lastblock	= 0;
+			std::unordered_map<row_key, row, row_key_hash>	rows;
+			index											owners;
+			index											authors;
+			index											categories;
+
+			std::deque<std::string>							changed;	// values written since the last checkpoint
+			const char*										mapping		= nullptr;
+			size_t											mapsize		= 0;
+	};
+}
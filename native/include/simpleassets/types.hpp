@@ -0,0 +1,136 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Native (off-chain) mirrors of the EOSIO base types used by SimpleAssets actions and tables.
+ *  Binary layout is the EOSIO wire format, so values can be read from and written to action
+ *  data and table rows directly.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+
+namespace simpleassets {
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	/*
+	* Account / table / action name (base32 encoded uint64).
+	*/
+	struct name {
+		uint64_t value = 0;
+
+		constexpr name() {}
+		constexpr explicit name( uint64_t v ) : value( v ) {}
+
+		explicit name( std::string_view str ) {
+			if ( str.size() > 13 )
+				throw std::invalid_argument( "name is longer than 13 characters: " + std::string( str ) );
+
+			for( size_t i = 0; i < str.size() && i < 12; ++i )
+				value |= ( char_to_value( str[i] ) & 0x1f ) << ( 64 - 5 * ( i + 1 ) );
+
+			if ( str.size() == 13 ) {
+				uint64_t v = char_to_value( str[12] );
+				if ( v > 0x0f )
+					throw std::invalid_argument( "thirteenth character of name cannot be a letter after j" );
+				value |= v;
+			}
+		}
+
+		std::string to_string() const {
+			static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+			std::string str( 13, '.' );
+
+			uint64_t tmp = value;
+			for( uint32_t i = 0; i <= 12; ++i ) {
+				char c = charmap[tmp & ( i == 0 ? 0x0f : 0x1f )];
+				str[12 - i] = c;
+				tmp >>= ( i == 0 ? 4 : 5 );
+			}
+
+			auto last = str.find_last_not_of( '.' );
+			str.resize( last == std::string::npos ? 0 : last + 1 );
+			return str;
+		}
+
+		bool operator==( const name& o ) const { return value == o.value; }
+		bool operator!=( const name& o ) const { return value != o.value; }
+		bool operator<( const name& o ) const { return value < o.value; }
+
+		private:
+			static uint64_t char_to_value( char c ) {
+				if ( c == '.' ) return 0;
+				if ( c >= '1' && c <= '5' ) return ( c - '1' ) + 1;
+				if ( c >= 'a' && c <= 'z' ) return ( c - 'a' ) + 6;
+				throw std::invalid_argument( std::string( "character is not in allowed character set for names: " ) + c );
+			}
+	};
+
+	inline name operator""_n( const char* s, size_t n ) {
+		return name( std::string_view( s, n ) );
+	}
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	/*
+	* Token symbol: precision in the low byte, up to 7 upper case characters above it.
+	*/
+	struct symbol {
+		uint64_t value = 0;
+
+		symbol() {}
+		explicit symbol( uint64_t v ) : value( v ) {}
+		symbol( std::string_view code, uint8_t precision ) {
+			for( size_t i = code.size(); i > 0; --i )
+				value = ( value << 8 ) | uint8_t( code[i - 1] );
+			value = ( value << 8 ) | precision;
+		}
+
+		uint8_t precision() const { return value & 0xff; }
+		uint64_t code_raw() const { return value >> 8; }
+
+		std::string code() const {
+			std::string s;
+			for( uint64_t v = value >> 8; v; v >>= 8 )
+				s += char( v & 0xff );
+			return s;
+		}
+
+		bool operator==( const symbol& o ) const { return value == o.value; }
+		bool operator!=( const symbol& o ) const { return value != o.value; }
+	};
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+	/*
+	* Token quantity, for example "10.0000 GOLD".
+	*/
+	struct asset {
+		int64_t		amount = 0;
+		symbol		sym;
+
+		std::string to_string() const {
+			std::string digits = std::to_string( amount < 0 ? -amount : amount );
+			uint8_t p = sym.precision();
+			if ( p > 0 ) {
+				if ( digits.size() <= p )
+					digits.insert( 0, p + 1 - digits.size(), '0' );
+				digits.insert( digits.size() - p, "." );
+			}
+			return ( amount < 0 ? "-" : "" ) + digits + " " + sym.code();
+		}
+	};
+
+
+	struct checksum256 {
+		uint8_t hash[32] = {};
+
+		bool operator==( const checksum256& o ) const { return memcmp( hash, o.hash, 32 ) == 0; }
+		bool operator!=( const checksum256& o ) const { return !( *this == o ); }
+	};
+}
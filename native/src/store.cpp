@@ -0,0 +1,293 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ */
+
+#include <simpleassets/store.hpp>
+
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace simpleassets {
+
+	namespace {
+		const char		magic[8]	= { 'S', 'A', 'S', 'T', 'O', 'R', 'E', '1' };
+		const uint32_t	version		= 1;
+
+		const name table_names[] = {
+			name( "sassets" ), name( "offers" ), name( "offerfs" ), name( "delegates" ), name( "accounts" ), name( "stat" ),
+			name( "authors" ), name( "global" ), name( "offersto" ), name( "offerfsto" ),
+			name( "accshards" )
+		};
+
+		struct file_writer {
+			FILE*	f;
+
+			void put( const void* data, size_t size ) {
+				if ( fwrite( data, 1, size, f ) != size )
+					throw std::runtime_error( "store: write failed" );
+			}
+
+			template<typename T>
+			void put( T v ) { put( &v, sizeof( T ) ); }
+
+			void put_varuint32( uint32_t v ) {
+				do {
+					uint8_t b = v & 0x7f;
+					v >>= 7;
+					put<uint8_t>( b | ( v ? 0x80 : 0 ) );
+				} while( v );
+			}
+		};
+	}
+
+	bool table_from_name( name table, table_id& id ) {
+		for( uint8_t i = 0; i < uint8_t( table_id::count ); ++i ) {
+			if ( table_names[i] == table ) {
+				id = table_id( i );
+				return true;
+			}
+		}
+
+		// partitioned offers and delegates share the row layout of the contract scoped tables
+		if ( table == name( "offersown" ) )		{ id = table_id::offers; return true; }
+		if ( table == name( "offerfsown" ) )	{ id = table_id::offerfs; return true; }
+		if ( table == name( "delegatesto" ) )	{ id = table_id::delegates; return true; }
+		return false;
+	}
+
+	name table_name( table_id id ) {
+		return table_names[uint8_t( id )];
+	}
+
+
+	store::store( std::string path ) : path( std::move( path ) ) {
+		load();
+	}
+
+	store::~store() {
+		unmap();
+	}
+
+	size_t store::size( table_id table ) const {
+		size_t n = 0;
+		for( const auto& r : rows )
+			n += r.first.table == uint8_t( table );
+		return n;
+	}
+
+	void store::upsert( table_id table, name scope, uint64_t primary_key, name payer, std::string_view value ) {
+		row_key k{ uint8_t( table ), scope.value, primary_key };
+
+		auto it = rows.find( k );
+		if ( it != rows.end() )
+			index_row( k, it->second.value, false );
+
+		changed.emplace_back( value );
+		row& r = rows[k];
+		r.payer = payer;
+		r.value = changed.back();
+
+		index_row( k, r.value, true );
+	}
+
+	void store::remove( table_id table, name scope, uint64_t primary_key ) {
+		row_key k{ uint8_t( table ), scope.value, primary_key };
+
+		auto it = rows.find( k );
+		if ( it == rows.end() )
+			return;
+
+		index_row( k, it->second.value, false );
+		rows.erase( it );
+	}
+
+	const row* store::get( table_id table, name scope, uint64_t primary_key ) const {
+		auto it = rows.find( { uint8_t( table ), scope.value, primary_key } );
+		return it == rows.end() ? nullptr : &it->second;
+	}
+
+	/*
+	* Adds (add == true) or removes the index entries of one row. Secondary keys come from
+	* the row value, so they are read with the zero-copy decoder.
+	*/
+	void store::index_row( const row_key& k, std::string_view value, bool add ) {
+		auto apply = [&]( index& idx, uint64_t key ) {
+			index_entry e{ k.table, key, k.scope, k.pk };
+			if ( add )
+				idx.insert( e );
+			else
+				idx.erase( e );
+		};
+
+		switch( table_id( k.table ) ) {
+			case table_id::sassets: {
+				sasset_view a;
+				decode( value, a );
+				apply( owners, k.scope );
+				apply( authors, a.author.value );
+				apply( categories, a.category.value );
+				break;
+			}
+			case table_id::offers: {
+				soffer_view o;
+				decode( value, o );
+				apply( owners, o.owner.value );
+				break;
+			}
+			case table_id::offerfs: {
+				sofferf_view o;
+				decode( value, o );
+				apply( owners, o.owner.value );
+				apply( authors, o.author.value );
+				break;
+			}
+			case table_id::offersto:
+			case table_id::accshards:
+				apply( owners, k.scope );
+				break;
+			case table_id::offerfsto: {
+				sofferf_view o;
+				decode( value, o );
+				apply( owners, k.scope );
+				apply( authors, o.author.value );
+				break;
+			}
+			case table_id::delegates: {
+				sdelegate_view d;
+				decode( value, d );
+				apply( owners, d.owner.value );
+				break;
+			}
+			case table_id::accounts: {
+				account_view a;
+				decode( value, a );
+				apply( owners, k.scope );
+				apply( authors, a.author.value );
+				break;
+			}
+			case table_id::stat:
+				apply( authors, k.scope );
+				break;
+			case table_id::authors: {
+				sauthor_view a;
+				decode( value, a );
+				apply( authors, a.author.value );
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	void store::load() {
+		int fd = open( path.c_str(), O_RDONLY );
+		if ( fd < 0 )
+			return;		// new store
+
+		struct stat st;
+		if ( fstat( fd, &st ) != 0 || st.st_size == 0 ) {
+			close( fd );
+			return;
+		}
+
+		void* m = mmap( nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		close( fd );
+		if ( m == MAP_FAILED )
+			throw std::runtime_error( "store: cannot map " + path );
+
+		mapping = (const char*)m;
+		mapsize = st.st_size;
+
+		reader rd( mapping, mapsize );
+		rd.need( sizeof( magic ) );
+		if ( memcmp( rd.position(), magic, sizeof( magic ) ) != 0 )
+			throw std::runtime_error( "store: not a SimpleAssets store: " + path );
+		rd.skip( sizeof( magic ) );
+
+		if ( rd.u32() != version )
+			throw std::runtime_error( "store: unsupported version: " + path );
+		lastblock = rd.u32();
+		uint64_t count = rd.u64();
+
+		rows.reserve( count );
+		for( uint64_t i = 0; i < count; ++i ) {
+			row_key k;
+			k.table	= rd.u8();
+			k.scope	= rd.u64();
+			k.pk	= rd.u64();
+
+			row& r = rows[k];
+			r.payer = rd.nm();
+			r.value = rd.str();
+			index_row( k, r.value, true );
+		}
+	}
+
+	void store::checkpoint() {
+		std::string tmp = path + ".tmp";
+		FILE* f = fopen( tmp.c_str(), "wb" );
+		if ( !f )
+			throw std::runtime_error( "store: cannot create " + tmp );
+
+		file_writer w{ f };
+		w.put( magic, sizeof( magic ) );
+		w.put<uint32_t>( version );
+		w.put<uint32_t>( lastblock );
+		w.put<uint64_t>( rows.size() );
+
+		// remember where each value lands, so rows can point into the new mapping afterwards
+		std::vector<std::pair<row*, size_t>> offsets;
+		offsets.reserve( rows.size() );
+		size_t pos = sizeof( magic ) + 16;
+
+		for( auto& r : rows ) {
+			w.put<uint8_t>( r.first.table );
+			w.put<uint64_t>( r.first.scope );
+			w.put<uint64_t>( r.first.pk );
+			w.put<uint64_t>( r.second.payer.value );
+
+			uint32_t size = r.second.value.size();
+			w.put_varuint32( size );
+			pos += 25 + ( size < 0x80 ? 1 : size < 0x4000 ? 2 : size < 0x200000 ? 3 : size < 0x10000000 ? 4 : 5 );
+
+			offsets.emplace_back( &r.second, pos );
+			w.put( r.second.value.data(), size );
+			pos += size;
+		}
+
+		if ( fflush( f ) != 0 || fsync( fileno( f ) ) != 0 ) {
+			fclose( f );
+			throw std::runtime_error( "store: cannot flush " + tmp );
+		}
+		fclose( f );
+
+		if ( rename( tmp.c_str(), path.c_str() ) != 0 )
+			throw std::runtime_error( "store: cannot replace " + path );
+
+		int fd = open( path.c_str(), O_RDONLY );
+		void* m = fd < 0 ? MAP_FAILED : mmap( nullptr, pos, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if ( fd >= 0 )
+			close( fd );
+		if ( m == MAP_FAILED )
+			throw std::runtime_error( "store: cannot map " + path );
+
+		for( auto& o : offsets )
+			o.first->value = std::string_view( (const char*)m + o.second, o.first->value.size() );
+
+		unmap();
+		mapping = (const char*)m;
+		mapsize = pos;
+		changed.clear();
+	}
+
+	void store::unmap() {
+		if ( mapping )
+			munmap( (void*)mapping, mapsize );
+		mapping = nullptr;
+		mapsize = 0;
+	}
+}
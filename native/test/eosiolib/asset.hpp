@@ -0,0 +1,39 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Host stand-in for eosiolib symbol / asset, see eosio.hpp.
+ */
+
+#pragma once
+
+#include <eosiolib/eosio.hpp>
+
+namespace eosio {
+
+	struct symbol_code {
+		uint64_t value = 0;
+		constexpr uint64_t raw() const { return value; }
+	};
+
+	struct symbol {
+		uint64_t value = 0;
+
+		constexpr symbol() = default;
+		constexpr symbol( const char* code, uint8_t precision ) : value( precision ) {
+			for( int i = 0; code[i]; ++i )
+				value |= uint64_t( uint8_t( code[i] ) ) << ( 8 * ( i + 1 ) );
+		}
+
+		constexpr uint64_t raw() const { return value; }
+		constexpr symbol_code code() const { return { value >> 8 }; }
+	};
+
+	struct asset {
+		int64_t	amount = 0;
+		symbol	sym;
+
+		asset() = default;
+		asset( int64_t a, symbol s ) : amount( a ), sym( s ) {}
+	};
+}
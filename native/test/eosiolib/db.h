@@ -0,0 +1,70 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Host stand-in for the eosiolib primary index db calls, backed by an in-memory store
+ *  (testdb::rows). Same return conventions as the chain: iterators are >= 0, -1 if not found,
+ *  db_get_i64 with size 0 returns the row size, otherwise the number of bytes copied.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace testdb {
+
+	using key = std::tuple<uint64_t, uint64_t, uint64_t, uint64_t>;		// code, scope, table, pk
+
+	inline std::map<key, std::string>& rows() {
+		static std::map<key, std::string> r;
+		return r;
+	}
+
+	// iterator handles: positions of the rows handed out so far
+	inline std::vector<std::map<key, std::string>::const_iterator>& handles() {
+		static std::vector<std::map<key, std::string>::const_iterator> h;
+		return h;
+	}
+
+	inline int32_t handle( std::map<key, std::string>::const_iterator it ) {
+		handles().push_back( it );
+		return int32_t( handles().size() - 1 );
+	}
+}
+
+inline int32_t db_find_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id ) {
+	auto it = testdb::rows().find( { code, scope, table, id } );
+	return it == testdb::rows().end() ? -1 : testdb::handle( it );
+}
+
+inline int32_t db_lowerbound_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id ) {
+	auto it = testdb::rows().lower_bound( { code, scope, table, id } );
+	if ( it == testdb::rows().end() || std::get<0>( it->first ) != code || std::get<1>( it->first ) != scope ||
+	     std::get<2>( it->first ) != table )
+		return -1;
+	return testdb::handle( it );
+}
+
+inline int32_t db_next_i64( int32_t itr, uint64_t* primary ) {
+	auto it = testdb::handles()[itr];
+	auto next = std::next( it );
+	if ( next == testdb::rows().end() || std::get<0>( next->first ) != std::get<0>( it->first ) ||
+	     std::get<1>( next->first ) != std::get<1>( it->first ) || std::get<2>( next->first ) != std::get<2>( it->first ) )
+		return -1;
+	*primary = std::get<3>( next->first );
+	return testdb::handle( next );
+}
+
+inline int32_t db_get_i64( int32_t itr, const void* data, uint32_t len ) {
+	const std::string& row = testdb::handles()[itr]->second;
+	if ( len == 0 )
+		return int32_t( row.size() );
+	uint32_t n = len < row.size() ? len : uint32_t( row.size() );
+	memcpy( const_cast<void*>( data ), row.data(), n );
+	return int32_t( n );
+}
@@ -0,0 +1,42 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Minimal host stand-in for the eosiolib parts include/SimpleAssetsReader.hpp uses, so the
+ *  reader can be tested natively against an in-memory table store (see db.h).
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace eosio {
+
+	struct name {
+		uint64_t value = 0;
+
+		constexpr name() = default;
+		constexpr explicit name( uint64_t v ) : value( v ) {}
+		constexpr explicit name( const char* s ) : value( 0 ) {
+			int i = 0;
+			for( ; s[i] && i < 12; ++i )
+				value |= ( char_value( s[i] ) & 0x1f ) << ( 64 - 5 * ( i + 1 ) );
+			if ( s[i] )
+				value |= char_value( s[i] ) & 0x0f;
+		}
+
+		static constexpr uint64_t char_value( char c ) {
+			if ( c >= 'a' && c <= 'z' ) return c - 'a' + 6;
+			if ( c >= '1' && c <= '5' ) return c - '1' + 1;
+			return 0;
+		}
+
+		constexpr bool operator==( const name& o ) const { return value == o.value; }
+		constexpr bool operator!=( const name& o ) const { return value != o.value; }
+	};
+}
+
+inline constexpr eosio::name operator""_n( const char* s, std::size_t ) {
+	return eosio::name( s );
+}
@@ -0,0 +1,149 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  Tests of include/SimpleAssetsReader.hpp against rows serialized the way the contract
+ *  stores them, in the in-memory table store of test/eosiolib/db.h.
+ */
+
+#include <SimpleAssetsReader.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+using eosio::name;
+using eosio::symbol;
+
+namespace {
+
+	int failures = 0;
+
+	void expect( bool ok, const char* what, int line ) {
+		if ( !ok ) {
+			fprintf( stderr, "line %d: %s\n", line, what );
+			failures++;
+		}
+	}
+
+	#define EXPECT( x ) expect( ( x ), #x, __LINE__ )
+
+	const name contract = "simpleassets"_n;
+	const name owner = "someowner111"_n;
+	const name author = "someauthor11"_n;
+	const name category = "weapon"_n;
+
+	struct row {
+		std::string bytes;
+
+		row& u64( uint64_t v ) { bytes.append( (const char*)&v, 8 ); return *this; }
+		row& u8( uint8_t v ) { bytes += char( v ); return *this; }
+		row& varuint( uint32_t v ) {
+			do {
+				uint8_t b = v & 0x7f;
+				v >>= 7;
+				u8( b | ( v ? 0x80 : 0 ) );
+			} while( v );
+			return *this;
+		}
+		row& str( const std::string& s ) { varuint( uint32_t( s.size() ) ); bytes += s; return *this; }
+	};
+
+	void put( name scope, name table, uint64_t pk, const row& r ) {
+		testdb::rows()[{ contract.value, scope.value, table.value, pk }] = r.bytes;
+	}
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+	std::string bitmap( uint64_t bits, std::initializer_list<uint64_t> set ) {
+		std::string res( ( bits + 7 ) / 8, '\0' );
+		for( uint64_t i : set )
+			res[i / 8] |= char( 1 << ( i % 8 ) );
+		return res;
+	}
+
+	// edition `first + i` was created for every i in `taken`; chunks in `done` are complete
+	// and have no dropbits row
+	void put_drop( uint64_t first, uint64_t count, std::initializer_list<uint64_t> taken, std::initializer_list<uint64_t> done ) {
+		const uint64_t chunk = 1024;
+		uint64_t chunks = ( count + chunk - 1 ) / chunk;
+
+		row r;
+		r.u64( first + count - 1 ).u64( first ).u64( author.value ).u64( category.value ).u64( owner.value )
+		 .u64( count - taken.size() - done.size() * chunk ).str( bitmap( chunks, done ) ).str( "{\"name\": \"shield\"}" ).str( "{}" );
+		put( owner, "drops"_n, first + count - 1, r );
+
+		for( uint64_t k = 0; k < chunks; ++k ) {
+			if ( std::find( done.begin(), done.end(), k ) != done.end() )
+				continue;
+			std::string bits = bitmap( std::min( chunk, count - k * chunk ), {} );
+			uint64_t left = std::min( chunk, count - k * chunk );
+			for( uint64_t i : taken )
+				if ( i / chunk == k ) {
+					bits[i % chunk / 8] |= char( 1 << ( i % 8 ) );
+					left--;
+				}
+			if ( left < std::min( chunk, count - k * chunk ) )
+				put( owner, "dropbits"_n, first + k * chunk, row().u64( first + k * chunk ).u64( left ).str( bits ) );
+		}
+	}
+
+	void test_drops() {
+		// 3000 editions: chunk 0 complete, 1500 and 1600 created in chunk 1, chunk 2 untouched
+		put_drop( 1000, 3000, { 1500, 1600 }, { 0 } );
+
+		EXPECT( !sareader::owns( contract, owner, 1000 ) );			// complete chunk
+		EXPECT( !sareader::owns( contract, owner, 2023 ) );
+		EXPECT( sareader::owns( contract, owner, 2024 ) );
+		EXPECT( !sareader::owns( contract, owner, 2500 ) );			// created, not in sassets here
+		EXPECT( sareader::owns( contract, owner, 2501 ) );
+		EXPECT( !sareader::owns( contract, owner, 2600 ) );
+		EXPECT( sareader::owns( contract, owner, 3047 ) );
+		EXPECT( sareader::owns( contract, owner, 3048 ) );			// chunk without a dropbits row
+		EXPECT( sareader::owns( contract, owner, 3999 ) );
+		EXPECT( !sareader::owns( contract, owner, 999 ) );
+		EXPECT( !sareader::owns( contract, owner, 4000 ) );
+		EXPECT( !sareader::owns( contract, "otherowner11"_n, 2501 ) );
+
+		sareader::sasset_head h;
+		EXPECT( sareader::get_head( contract, owner, 3900, h ) );
+		EXPECT( h.id == 3900 && h.owner == owner && h.author == author && h.category == category );
+		EXPECT( !sareader::get_head( contract, owner, 2500, h ) );
+
+		// a created edition is found in sassets
+		put( owner, "sassets"_n, 2500, row().u64( 2500 ).u64( owner.value ).u64( author.value ).u64( category.value ).str( "" ).str( "" ) );
+		EXPECT( sareader::owns( contract, owner, 2500 ) );
+	}
+
+	void test_balances() {
+		symbol gold( "GOLD", 2 );
+		uint64_t ftid = 100000000000007;
+
+		row st;
+		st.u64( 500 ).u64( gold.raw() ).u64( 1000 ).u64( gold.raw() ).u64( author.value ).u64( ftid ).u8( 0 ).str( "" );
+		put( author, "stat"_n, gold.code().raw(), st );
+
+		EXPECT( sareader::balance_of( contract, owner, author, gold ).amount == 0 );
+
+		put( owner, "accounts"_n, ftid, row().u64( ftid ).u64( author.value ).u64( 120 ).u64( gold.raw() ) );
+		EXPECT( sareader::balance_of( contract, owner, author, gold ).amount == 120 );
+
+		put( owner, "accshards"_n, ftid << 4 | 3, row().u64( ftid << 4 | 3 ).u64( 30 ).u64( gold.raw() ) );
+		put( owner, "accshards"_n, ftid << 4 | 9, row().u64( ftid << 4 | 9 ).u64( 7 ).u64( gold.raw() ) );
+		put( owner, "accshards"_n, ( ftid + 1 ) << 4, row().u64( ( ftid + 1 ) << 4 ).u64( 1000 ).u64( gold.raw() ) );		// other token
+		EXPECT( sareader::balance_of( contract, owner, author, gold ).amount == 157 );
+	}
+}
+
+int main() {
+	test_drops();
+	test_balances();
+
+	if ( failures ) {
+		fprintf( stderr, "%d failed\n", failures );
+		return 1;
+	}
+	printf( "ok\n" );
+	return 0;
+}
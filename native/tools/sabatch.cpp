@@ -0,0 +1,191 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  sabatch - calibrates the batch cost model and splits large asset id lists into transactions.
+ *
+ *  Usage:
+ *    sabatch calibrate <calib.csv> <model.txt>
+ *    sabatch split <model.txt> <action> [-s store -o owner] [-c cpu_us] [-n net_bytes] [-m margin] [-x max_assets] [-k]
+ *
+ *  calib.csv is written by `tools/loadgen.sh calibrate`. The model file has one line per action:
+ *    action base per_asset per_byte per_nested per_author net_base net_per_asset r2 samples
+ *
+ *  split reads items from stdin, one per line: `id` (features are looked up in the saindex store
+ *  given with -s, scope -o) or `id,payload_bytes,nested,author`. It prints one JSON id array per
+ *  transaction, ready for the assetids parameter, and the predicted cost of each to stderr.
+ *  -k keeps the input order instead of grouping items by author.
+ */
+
+#include <simpleassets/batch.hpp>
+#include <simpleassets/store.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+
+using namespace simpleassets;
+
+namespace {
+
+	std::vector<std::string> split_csv( const std::string& line ) {
+		std::vector<std::string> out;
+		std::stringstream ss( line );
+		for( std::string f; std::getline( ss, f, ',' ); )
+			out.push_back( f );
+		return out;
+	}
+
+	int calibrate( const std::string& csv, const std::string& out ) {
+		std::ifstream in( csv );
+		if ( !in ) {
+			fprintf( stderr, "cannot open %s\n", csv.c_str() );
+			return 1;
+		}
+
+		std::map<std::string, std::vector<cost_sample>> samples;
+		std::string line;
+		std::getline( in, line );	// header
+		while( std::getline( in, line ) ) {
+			auto f = split_csv( line );
+			if ( f.size() < 7 || f[1].empty() )
+				continue;
+
+			cost_sample s;
+			s.cpu_us		= std::stod( f[1] );
+			s.net_bytes		= std::stod( f[2] );
+			s.assets		= std::stoul( f[3] );
+			s.payload_bytes	= std::stoul( f[4] );
+			s.nested		= std::stoul( f[5] );
+			s.authors		= std::stoul( f[6] );
+			samples[f[0]].push_back( s );
+		}
+
+		FILE* mf = fopen( out.c_str(), "w" );
+		if ( !mf ) {
+			fprintf( stderr, "cannot create %s\n", out.c_str() );
+			return 1;
+		}
+
+		printf( "%-12s %8s %9s %9s %9s %9s %9s %9s %6s %7s\n", "action", "base", "/asset", "/byte", "/nested", "/author",
+			"net", "net/asset", "r2", "samples" );
+		for( const auto& s : samples ) {
+			action_cost m = fit( s.second );
+			const char* fmt = "%-12s %8.1f %9.3f %9.5f %9.3f %9.3f %9.1f %9.2f %6.3f %7zu\n";
+			printf( fmt, s.first.c_str(), m.cpu[0], m.cpu[1], m.cpu[2], m.cpu[3], m.cpu[4], m.net_base, m.net_per_asset, m.r2, m.samples );
+			fprintf( mf, "%s %.6g %.6g %.6g %.6g %.6g %.6g %.6g %.4f %zu\n", s.first.c_str(), m.cpu[0], m.cpu[1], m.cpu[2], m.cpu[3], m.cpu[4],
+				m.net_base, m.net_per_asset, m.r2, m.samples );
+		}
+		fclose( mf );
+		return 0;
+	}
+
+	bool load_model( const std::string& path, const std::string& action, action_cost& m ) {
+		std::ifstream in( path );
+		std::string a;
+		while( in >> a >> m.cpu[0] >> m.cpu[1] >> m.cpu[2] >> m.cpu[3] >> m.cpu[4] >> m.net_base >> m.net_per_asset >> m.r2 >> m.samples ) {
+			if ( a == action )
+				return true;
+		}
+		return false;
+	}
+
+	int split_items( const std::string& model_path, const std::string& action, const std::vector<std::string>& opts ) {
+		action_cost model;
+		if ( !load_model( model_path, action, model ) ) {
+			fprintf( stderr, "no model for %s in %s\n", action.c_str(), model_path.c_str() );
+			return 1;
+		}
+
+		batch_limits limits;
+		std::string store_path;
+		name owner;
+		bool group = true;
+		for( size_t i = 0; i < opts.size(); ++i ) {
+			bool has = i + 1 < opts.size();
+			if ( opts[i] == "-k" )				group = false;
+			else if ( opts[i] == "-s" && has )	store_path = opts[++i];
+			else if ( opts[i] == "-o" && has )	owner = name( opts[++i] );
+			else if ( opts[i] == "-c" && has )	limits.cpu_us = std::stod( opts[++i] );
+			else if ( opts[i] == "-n" && has )	limits.net_bytes = std::stod( opts[++i] );
+			else if ( opts[i] == "-m" && has )	limits.margin = std::stod( opts[++i] );
+			else if ( opts[i] == "-x" && has )	limits.max_assets = std::stoul( opts[++i] );
+			else return 2;
+		}
+
+		std::unique_ptr<store> db;
+		if ( !store_path.empty() )
+			db.reset( new store( store_path ) );
+
+		std::vector<batch_item> items;
+		for( std::string line; std::getline( std::cin, line ); ) {
+			auto f = split_csv( line );
+			if ( f.empty() || f[0].empty() )
+				continue;
+
+			batch_item it;
+			it.id = std::stoull( f[0] );
+			if ( f.size() >= 4 ) {
+				it.payload_bytes	= std::stoul( f[1] );
+				it.nested			= std::stoul( f[2] );
+				it.author			= name( f[3] );
+			} else if ( db ) {
+				const row* r = db->get( table_id::sassets, owner, it.id );
+				if ( !r ) {
+					fprintf( stderr, "asset %llu of %s not in store\n", (unsigned long long)it.id, owner.to_string().c_str() );
+					return 1;
+				}
+				it = item_from_row( decode<sasset_view>( r->value ) );
+			}
+			items.push_back( it );
+		}
+
+		auto ends = split( items, model, limits, group );
+
+		size_t begin = 0;
+		for( size_t end : ends ) {
+			uint32_t nested = 0, authors = 0;
+			uint64_t payload = 0;
+			printf( "[" );
+			for( size_t i = begin; i < end; ++i ) {
+				printf( i > begin ? ",%llu" : "%llu", (unsigned long long)items[i].id );
+				payload += items[i].payload_bytes;
+				nested += items[i].nested;
+				authors += i == begin || items[i].author != items[i - 1].author;
+			}
+			printf( "]\n" );
+			fprintf( stderr, "%zu assets: cpu %.0f us, net %.0f bytes\n", end - begin,
+				model.cpu_us( end - begin, payload, nested, authors ), model.net_bytes( end - begin ) );
+			begin = end;
+		}
+		fprintf( stderr, "%zu items in %zu transactions\n", items.size(), ends.size() );
+		return 0;
+	}
+
+	int usage() {
+		fprintf( stderr,
+			"usage: sabatch calibrate <calib.csv> <model.txt>\n"
+			"       sabatch split <model.txt> <action> [-s store -o owner] [-c cpu_us] [-n net_bytes] [-m margin] [-x max_assets] [-k]\n" );
+		return 2;
+	}
+}
+
+int main( int argc, char** argv ) {
+	std::vector<std::string> args( argv + 1, argv + argc );
+
+	try {
+		if ( args.size() == 3 && args[0] == "calibrate" )
+			return calibrate( args[1], args[2] );
+		if ( args.size() >= 3 && args[0] == "split" ) {
+			int r = split_items( args[1], args[2], std::vector<std::string>( args.begin() + 3, args.end() ) );
+			return r == 2 ? usage() : r;
+		}
+	} catch( const std::exception& e ) {
+		fprintf( stderr, "error: %s\n", e.what() );
+		return 1;
+	}
+	return usage();
+}
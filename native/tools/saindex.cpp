@@ -0,0 +1,378 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  saindex - streaming state-history indexer for SimpleAssets tables.
+ *
+ *  Reads state-history `result` messages (get_blocks_result_v0), keeps the contract_row deltas
+ *  of the SimpleAssets account and maintains a local store (see simpleassets/store.hpp).
+ *  Blocks are decoded in parallel by worker threads and applied strictly in stream order.
+ *
+ *  Usage:
+ *    saindex ingest <source> <store> [-c contract] [-t threads] [-k checkpoint_blocks]
+ *    saindex query  <store> owner|author|category <name> [table]
+ *    saindex stats  <store>
+ *    saindex zero   <store> <author> [-c contract]
+ *
+ *  zero lists, per token of author, the accounts with a zero balance row paid by the author or
+ *  the contract and no balance shards, 200 per line, as input for the sweepf action.
+ *
+ *  source - file, '-' for stdin, or host:port of a local stand-in endpoint. Each message is
+ *           framed as uint32 little endian size followed by the message bytes. Only irreversible
+ *           blocks should be fed: forks are not rolled back, and blocks at or below the last
+ *           block in the store are skipped, so an interrupted ingest can be resumed.
+ */
+
+#include <simpleassets/ship.hpp>
+#include <simpleassets/store.hpp>
+
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace simpleassets;
+
+namespace {
+
+	struct change {
+		table_id			table;
+		name				scope;
+		uint64_t			pk;
+		name				payer;
+		bool				present;
+		std::string_view	value;
+	};
+
+	struct decoded_block {
+		std::string			msg;		// keeps change values alive
+		uint32_t			block_num = 0;
+		std::vector<change>	changes;
+	};
+
+	int open_source( const std::string& src ) {
+		if ( src == "-" )
+			return 0;
+
+		auto colon = src.rfind( ':' );
+		if ( access( src.c_str(), R_OK ) == 0 || colon == std::string::npos )
+			return open( src.c_str(), O_RDONLY );
+
+		addrinfo hints = {}, *res = nullptr;
+		hints.ai_socktype = SOCK_STREAM;
+		if ( getaddrinfo( src.substr( 0, colon ).c_str(), src.substr( colon + 1 ).c_str(), &hints, &res ) != 0 )
+			return -1;
+
+		int fd = socket( res->ai_family, res->ai_socktype, res->ai_protocol );
+		if ( fd >= 0 && connect( fd, res->ai_addr, res->ai_addrlen ) != 0 ) {
+			close( fd );
+			fd = -1;
+		}
+		freeaddrinfo( res );
+		return fd;
+	}
+
+	bool read_all( int fd, char* buf, size_t size ) {
+		while( size ) {
+			ssize_t n = read( fd, buf, size );
+			if ( n <= 0 )
+				return false;
+			buf += n;
+			size -= n;
+		}
+		return true;
+	}
+
+	bool read_frame( int fd, std::string& msg ) {
+		uint32_t size;
+		if ( !read_all( fd, (char*)&size, 4 ) )
+			return false;
+		msg.resize( size );
+		return read_all( fd, msg.data(), size );
+	}
+
+	void decode_block( decoded_block& b, name code ) {
+		ship::get_blocks_result res;
+		if ( !ship::parse_result( b.msg, res ) || !res.this_block )
+			return;
+
+		b.block_num = res.this_block->block_num;
+		if ( !res.deltas )
+			return;
+
+		ship::for_each_contract_row( *res.deltas, code, [&]( const ship::contract_row& r ) {
+			table_id t;
+			if ( table_from_name( r.table, t ) )
+				b.changes.push_back( { t, r.scope, r.primary_key, r.payer, r.present, r.value } );
+		});
+	}
+
+	int ingest( const std::string& src, const std::string& path, name code, unsigned threads, uint32_t every ) {
+		int fd = open_source( src );
+		if ( fd < 0 ) {
+			fprintf( stderr, "cannot open source %s\n", src.c_str() );
+			return 1;
+		}
+
+		store db( path );
+		uint32_t start = db.last_block();
+		fprintf( stderr, "store %s: %zu rows, last block %u\n", path.c_str(), db.size(), start );
+
+		const size_t window = threads * 8;		// max blocks read ahead of the applier
+
+		std::mutex mtx;
+		std::condition_variable cv;
+		std::queue<std::pair<uint64_t, std::string>> todo;
+		std::map<uint64_t, decoded_block> done;
+		uint64_t next_seq = 0, applied = 0;
+		bool eof = false;
+		std::string error;
+
+		std::vector<std::thread> workers;
+		for( unsigned i = 0; i < threads; ++i ) {
+			workers.emplace_back( [&] {
+				std::unique_lock<std::mutex> lock( mtx );
+				for(;;) {
+					cv.wait( lock, [&] { return !todo.empty() || eof; } );
+					if ( todo.empty() )
+						return;
+
+					auto job = std::move( todo.front() );
+					todo.pop();
+					lock.unlock();
+
+					decoded_block b;
+					b.msg = std::move( job.second );
+					try {
+						decode_block( b, code );
+					} catch( const std::exception& e ) {
+						b.changes.clear();
+						lock.lock();
+						error = e.what();
+						lock.unlock();
+					}
+
+					lock.lock();
+					done.emplace( job.first, std::move( b ) );
+					cv.notify_all();
+				}
+			});
+		}
+
+		std::thread input( [&] {
+			std::string msg;
+			for(;;) {
+				bool ok = read_frame( fd, msg );
+				std::unique_lock<std::mutex> lock( mtx );
+				if ( !ok || !error.empty() ) {
+					eof = true;
+					cv.notify_all();
+					return;
+				}
+				cv.wait( lock, [&] { return next_seq - applied < window || eof; } );
+				if ( eof )
+					return;
+				todo.emplace( next_seq++, std::move( msg ) );
+				cv.notify_all();
+			}
+		});
+
+		uint32_t last = start, since = 0;
+		size_t changes = 0;
+		for(;;) {
+			decoded_block b;
+			{
+				std::unique_lock<std::mutex> lock( mtx );
+				cv.wait( lock, [&] { return done.count( applied ) || ( eof && applied == next_seq ) || !error.empty(); } );
+				if ( !error.empty() || !done.count( applied ) )
+					break;
+
+				b = std::move( done[applied] );
+				done.erase( applied++ );
+				cv.notify_all();
+			}
+
+			if ( b.block_num == 0 || b.block_num <= start )
+				continue;
+
+			for( const auto& c : b.changes ) {
+				if ( c.present )
+					db.upsert( c.table, c.scope, c.pk, c.payer, c.value );
+				else
+					db.remove( c.table, c.scope, c.pk );
+			}
+			changes += b.changes.size();
+			last = b.block_num;
+			db.set_last_block( last );
+
+			if ( ++since >= every ) {
+				db.checkpoint();
+				since = 0;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock( mtx );
+			eof = true;
+			cv.notify_all();
+		}
+		shutdown( fd, SHUT_RD );		// unblocks the input thread on sockets, no-op for files
+		input.join();
+		for( auto& w : workers )
+			w.join();
+		if ( fd > 0 )
+			close( fd );
+
+		db.checkpoint();
+		fprintf( stderr, "applied %zu row changes up to block %u, %zu rows\n", changes, last, db.size() );
+
+		if ( !error.empty() ) {
+			fprintf( stderr, "stopped on bad message: %s\n", error.c_str() );
+			return 1;
+		}
+		return 0;
+	}
+
+	// balance shards of token `id` held by `owner` (see setshards): sum and number of rows
+	std::pair<int64_t, int> shards( const store& db, name owner, uint64_t id ) {
+		std::pair<int64_t, int> res{ 0, 0 };
+		for( uint64_t s = 0; s < 16; ++s ) {
+			if ( const row* r = db.get( table_id::accshards, owner, id << 4 | s ) ) {
+				res.first += decode<accshard_view>( r->value ).balance.amount;
+				res.second++;
+			}
+		}
+		return res;
+	}
+
+	void print_row( const store& db, table_id t, name scope, uint64_t pk, const row& r ) {
+		printf( "%-10s %-13s %20llu  ", table_name( t ).to_string().c_str(), scope.to_string().c_str(), (unsigned long long)pk );
+
+		if ( t == table_id::sassets ) {
+			auto a = decode<sasset_view>( r.value );
+			printf( "owner=%s author=%s category=%s idata=%.*s\n", a.owner.to_string().c_str(), a.author.to_string().c_str(),
+				a.category.to_string().c_str(), int( a.idata.size() ), a.idata.data() );
+		} else if ( t == table_id::accounts ) {
+			auto a = decode<account_view>( r.value );
+			auto sh = shards( db, scope, a.id );
+			a.balance.amount += sh.first;
+			printf( "author=%s balance=%s", a.author.to_string().c_str(), a.balance.to_string().c_str() );
+			if ( sh.second )
+				printf( " (%d shards)", sh.second );
+			printf( "\n" );
+		} else if ( t == table_id::accshards ) {
+			auto s = decode<accshard_view>( r.value );
+			printf( "id=%llu shard=%llu balance=%s\n", (unsigned long long)( s.key >> 4 ), (unsigned long long)( s.key & 15 ),
+				s.balance.to_string().c_str() );
+		} else {
+			printf( "%zu bytes\n", r.value.size() );
+		}
+	}
+
+	int query( const std::string& path, const std::string& kind, name key, const std::string& table ) {
+		store db( path );
+
+		for( uint8_t i = 0; i < uint8_t( table_id::count ); ++i ) {
+			table_id t = table_id( i );
+			if ( !table.empty() && table_name( t ) != name( table ) )
+				continue;
+
+			auto f = [&]( name scope, uint64_t pk, const row& r ) { print_row( db, t, scope, pk, r ); };
+			if ( kind == "owner" )
+				db.by_owner( t, key, f );
+			else if ( kind == "author" )
+				db.by_author( t, key, f );
+			else if ( kind == "category" )
+				db.by_category( t, key, f );
+			else
+				return 2;
+		}
+		return 0;
+	}
+
+	int stats( const std::string& path ) {
+		store db( path );
+		printf( "last block %u, %zu rows\n", db.last_block(), db.size() );
+		for( uint8_t i = 0; i < uint8_t( table_id::count ); ++i ) {
+			table_id table = table_id( i );
+
+			// approximate RAM as billed by the chain: row + 112 bytes overhead. The contract's
+			// tablestats (setstats) count offers with offersto, offerfs with offerfsto.
+			uint64_t bytes = 0;
+			db.for_each( table, [&]( name, uint64_t, const row& r ) { bytes += r.value.size() + 112; } );
+
+			printf( "  %-10s %10zu rows %14llu bytes\n", table_name( table ).to_string().c_str(), db.size( table ), (unsigned long long)bytes );
+		}
+		return 0;
+	}
+
+	int zero( const std::string& path, name author, name code ) {
+		store db( path );
+
+		std::map< std::string, std::vector<name> > owners;		// symbol code -> accounts
+		db.by_author( table_id::accounts, author, [&]( name scope, uint64_t, const row& r ) {
+			// sweepf skips accounts with balance shards of the token, even empty ones
+			auto a = decode<account_view>( r.value );
+			if ( a.balance.amount == 0 && ( r.payer == author || r.payer == code ) && shards( db, scope, a.id ).second == 0 )
+				owners[a.balance.sym.code()].push_back( scope );
+		});
+
+		for( const auto& o : owners ) {
+			for( size_t i = 0; i < o.second.size(); i += 200 ) {
+				printf( "%s", o.first.c_str() );
+				for( size_t k = i; k < std::min( i + 200, o.second.size() ); ++k )
+					printf( " %s", o.second[k].to_string().c_str() );
+				printf( "\n" );
+			}
+		}
+		return 0;
+	}
+
+	int usage() {
+		fprintf( stderr,
+			"usage: saindex ingest <source> <store> [-c contract] [-t threads] [-k checkpoint_blocks]\n"
+			"       saindex query  <store> owner|author|category <name> [table]\n"
+			"       saindex stats  <store>\n"
+			"       saindex zero   <store> <author> [-c contract]\n" );
+		return 2;
+	}
+}
+
+int main( int argc, char** argv ) {
+	std::vector<std::string> args( argv + 1, argv + argc );
+
+	try {
+		if ( args.size() >= 3 && args[0] == "ingest" ) {
+			name code( "simpleassets" );
+			unsigned threads = std::max( 1u, std::thread::hardware_concurrency() );
+			uint32_t every = 10000;
+
+			for( size_t i = 3; i + 1 < args.size(); i += 2 ) {
+				if ( args[i] == "-c" )		code = name( args[i + 1] );
+				else if ( args[i] == "-t" )	threads = std::max( 1, std::stoi( args[i + 1] ) );
+				else if ( args[i] == "-k" )	every = std::max( 1, std::stoi( args[i + 1] ) );
+				else return usage();
+			}
+			return ingest( args[1], args[2], code, threads, every );
+		}
+		if ( args.size() >= 4 && args[0] == "query" )
+			return query( args[1], args[2], name( args[3] ), args.size() > 4 ? args[4] : "" ) == 2 ? usage() : 0;
+		if ( args.size() == 2 && args[0] == "stats" )
+			return stats( args[1] );
+		if ( args.size() == 3 && args[0] == "zero" )
+			return zero( args[1], name( args[2] ), name( "simpleassets" ) );
+		if ( args.size() == 5 && args[0] == "zero" && args[3] == "-c" )
+			return zero( args[1], name( args[2] ), name( args[4] ) );
+	} catch( const std::exception& e ) {
+		fprintf( stderr, "error: %s\n", e.what() );
+		return 1;
+	}
+	return usage();
+}
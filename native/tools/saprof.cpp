@@ -0,0 +1,215 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  saprof - per-function CPU reports for the contract, from profiles of SimpleAssets.wasm run
+ *  on a local chain (see simpleassets/profile.hpp for the profile format).
+ *
+ *  Usage:
+ *    saprof top    <wasm> <profile>... [-n N] [-c]
+ *    saprof folded <wasm> [label=]<profile>... [-c]
+ *    saprof diff   <before.wasm> <before.profile> <after.wasm> <after.profile> [-n N] [-c]
+ *
+ *  top    - the N (default 30) functions with the most self time, with their total (inclusive)
+ *           time; intrinsics are listed as "[host] name".
+ *  folded - one line per distinct stack, "frame;frame;... count", the input of flamegraph.pl.
+ *           With label=, stacks of that profile start with the frame `label`, so profiles of
+ *           different actions can be drawn as one graph.
+ *  diff   - self time per function of two contract builds on the same replay, sorted by the
+ *           size of the change.
+ *  -c     - pcs are offsets into the code section instead of the module.
+ *
+ *  One profile per action: replay only that action type, e.g.
+ *    grep -P '^claim\t' loadgen/actions.log > claim.log && ./tools/loadgen.sh replay claim.log
+ *  with nodeos --profile-account <contract>, and keep the profile file it writes.
+ */
+
+#include <simpleassets/profile.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace simpleassets;
+
+namespace {
+
+	std::string read_file( const std::string& path ) {
+		std::ifstream in( path, std::ios::binary );
+		if ( !in )
+			throw std::runtime_error( "cannot open " + path );
+		std::ostringstream ss;
+		ss << in.rdbuf();
+		return ss.str();
+	}
+
+	struct times {
+		uint64_t	self = 0;
+		uint64_t	total = 0;
+	};
+
+	// samples per function, self and inclusive
+	std::unordered_map<std::string, times> by_function( const wasmprof::module& m, const wasmprof::profile& p, bool code_relative ) {
+		std::unordered_map<std::string, times> res;
+		for( const auto& s : p.samples ) {
+			auto frames = m.frames( s, code_relative );
+			if ( frames.empty() )
+				frames.push_back( "[unknown]" );
+
+			res[frames.back()].self += s.count;
+			std::unordered_set<std::string> seen;		// recursion counts once
+			for( const auto& f : frames )
+				if ( seen.insert( f ).second )
+					res[f].total += s.count;
+		}
+		return res;
+	}
+
+	double ms( uint64_t samples, uint64_t period_usec ) {
+		return double( samples ) * period_usec / 1000.0;
+	}
+
+
+	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+	int top( const std::string& wasm_path, const std::vector<std::string>& profiles, size_t n, bool code_relative ) {
+		std::string wasm = read_file( wasm_path );
+		auto m = wasmprof::load_module( wasm );
+
+		std::unordered_map<std::string, times> all;
+		uint64_t total = 0, period = 0;
+		for( const auto& path : profiles ) {
+			auto p = wasmprof::load_profile( read_file( path ) );
+			for( const auto& f : by_function( m, p, code_relative ) ) {
+				all[f.first].self += f.second.self;
+				all[f.first].total += f.second.total;
+			}
+			total += p.total();
+			period = p.period_usec;
+		}
+
+		std::vector<std::pair<std::string, times>> rows( all.begin(), all.end() );
+		std::sort( rows.begin(), rows.end(), []( const auto& a, const auto& b ) {
+			return a.second.self != b.second.self ? a.second.self > b.second.self : a.first < b.first;
+		});
+
+		printf( "%llu samples, %.1f ms\n\n", (unsigned long long)total, ms( total, period ) );
+		printf( "%7s %10s %7s %10s  %s\n", "self%", "self ms", "total%", "total ms", "function" );
+		for( size_t i = 0; i < rows.size() && i < n; ++i ) {
+			const auto& t = rows[i].second;
+			printf( "%6.2f%% %10.2f %6.2f%% %10.2f  %s\n", 100.0 * t.self / std::max<uint64_t>( total, 1 ), ms( t.self, period ),
+				100.0 * t.total / std::max<uint64_t>( total, 1 ), ms( t.total, period ), rows[i].first.c_str() );
+		}
+		return 0;
+	}
+
+	int folded( const std::string& wasm_path, const std::vector<std::string>& profiles, bool code_relative ) {
+		std::string wasm = read_file( wasm_path );
+		auto m = wasmprof::load_module( wasm );
+
+		std::map<std::string, uint64_t> stacks;
+		for( const auto& arg : profiles ) {
+			auto eq = arg.find( '=' );
+			std::string label = eq == std::string::npos ? "" : arg.substr( 0, eq );
+			auto p = wasmprof::load_profile( read_file( eq == std::string::npos ? arg : arg.substr( eq + 1 ) ) );
+
+			for( const auto& s : p.samples ) {
+				std::string key = label;
+				for( const auto& f : m.frames( s, code_relative ) ) {
+					if ( !key.empty() )
+						key += ';';
+					// flamegraph.pl splits frames on ';' and the count on the last ' '
+					for( char c : f )
+						key += c == ';' ? ',' : c;
+				}
+				if ( !key.empty() )
+					stacks[key] += s.count;
+			}
+		}
+
+		for( const auto& s : stacks )
+			printf( "%s %llu\n", s.first.c_str(), (unsigned long long)s.second );
+		return 0;
+	}
+
+	int diff( const std::string& wasm_a, const std::string& prof_a, const std::string& wasm_b, const std::string& prof_b,
+	          size_t n, bool code_relative ) {
+		std::string wa = read_file( wasm_a ), wb = read_file( wasm_b );
+		auto ma = wasmprof::load_module( wa );
+		auto mb = wasmprof::load_module( wb );
+		auto pa = wasmprof::load_profile( read_file( prof_a ) );
+		auto pb = wasmprof::load_profile( read_file( prof_b ) );
+
+		auto ta = by_function( ma, pa, code_relative );
+		auto tb = by_function( mb, pb, code_relative );
+
+		struct change {
+			std::string	name;
+			double		before;
+			double		after;
+		};
+		std::vector<change> rows;
+		for( const auto& f : ta )
+			rows.push_back( { f.first, ms( f.second.self, pa.period_usec ), 0 } );
+		for( auto& r : rows ) {
+			auto it = tb.find( r.name );
+			if ( it != tb.end() )
+				r.after = ms( it->second.self, pb.period_usec );
+		}
+		for( const auto& f : tb )
+			if ( !ta.count( f.first ) )
+				rows.push_back( { f.first, 0, ms( f.second.self, pb.period_usec ) } );
+
+		std::sort( rows.begin(), rows.end(), []( const change& a, const change& b ) {
+			double da = std::fabs( a.after - a.before ), db = std::fabs( b.after - b.before );
+			return da != db ? da > db : a.name < b.name;
+		});
+
+		double before = ms( pa.total(), pa.period_usec ), after = ms( pb.total(), pb.period_usec );
+		printf( "total %.1f ms -> %.1f ms (%+.1f%%)\n\n", before, after, before > 0 ? 100.0 * ( after - before ) / before : 0.0 );
+		printf( "%10s %10s %10s  %s\n", "before ms", "after ms", "delta ms", "function (self time)" );
+		for( size_t i = 0; i < rows.size() && i < n; ++i )
+			printf( "%10.2f %10.2f %+10.2f  %s\n", rows[i].before, rows[i].after, rows[i].after - rows[i].before, rows[i].name.c_str() );
+		return 0;
+	}
+
+	int usage() {
+		fprintf( stderr,
+			"usage: saprof top    <wasm> <profile>... [-n N] [-c]\n"
+			"       saprof folded <wasm> [label=]<profile>... [-c]\n"
+			"       saprof diff   <before.wasm> <before.profile> <after.wasm> <after.profile> [-n N] [-c]\n" );
+		return 2;
+	}
+}
+
+int main( int argc, char** argv ) {
+	std::vector<std::string> args;
+	size_t n = 30;
+	bool code_relative = false;
+
+	for( int i = 1; i < argc; ++i ) {
+		std::string a = argv[i];
+		if ( a == "-n" && i + 1 < argc )
+			n = std::stoul( argv[++i] );
+		else if ( a == "-c" )
+			code_relative = true;
+		else
+			args.push_back( a );
+	}
+
+	try {
+		if ( args.size() >= 3 && args[0] == "top" )
+			return top( args[1], { args.begin() + 2, args.end() }, n, code_relative );
+		if ( args.size() >= 3 && args[0] == "folded" )
+			return folded( args[1], { args.begin() + 2, args.end() }, code_relative );
+		if ( args.size() == 5 && args[0] == "diff" )
+			return diff( args[1], args[2], args[3], args[4], n, code_relative );
+	} catch( const std::exception& e ) {
+		fprintf( stderr, "error: %s\n", e.what() );
+		return 1;
+	}
+	return usage();
+}
@@ -0,0 +1,139 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  saproof - ownership proofs against the contract's Merkle commitment (see setmerkle).
+ *
+ *  Usage:
+ *    saproof root <store>
+ *    saproof prove <store> <assetid>
+ *    saproof verify <root>                 (proof on stdin)
+ *
+ *  The tree is built from the sassets rows of a saindex store, so its root equals the root in
+ *  the contract's merkle table at the store's last block. A proof is printed as text:
+ *    <assetid> <owner, `.` if the asset is not in any sassets table>
+ *    <mask, 16 hex digits>
+ *    <sibling, 64 hex digits>   (one line per set mask bit)
+ */
+
+#include <simpleassets/merkle.hpp>
+#include <simpleassets/store.hpp>
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+using namespace simpleassets;
+
+namespace {
+
+	std::string to_hex( const checksum256& h ) {
+		static const char* digits = "0123456789abcdef";
+		std::string s;
+		for( uint8_t b : h.hash ) {
+			s += digits[b >> 4];
+			s += digits[b & 15];
+		}
+		return s;
+	}
+
+	bool from_hex( const std::string& s, checksum256& h ) {
+		if ( s.size() != 64 )
+			return false;
+		for( size_t i = 0; i < 32; ++i ) {
+			try {
+				h.hash[i] = uint8_t( std::stoul( s.substr( 2 * i, 2 ), nullptr, 16 ) );
+			} catch( const std::exception& ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	merkle::tree load( const store& db ) {
+		merkle::tree t;
+		db.for_each( table_id::sassets, [&]( name scope, uint64_t pk, const row& ) {
+			t.put( pk, scope );
+		});
+		t.build();
+		fprintf( stderr, "%zu assets at block %u\n", t.size(), db.last_block() );
+		return t;
+	}
+
+	int prove( const std::string& path, uint64_t assetid ) {
+		store db( path );
+		merkle::tree t = load( db );
+
+		name owner;
+		db.for_each( table_id::sassets, [&]( name scope, uint64_t pk, const row& ) {
+			if ( pk == assetid )
+				owner = scope;
+		});
+
+		merkle::proof p = t.prove( assetid );
+		printf( "%llu %s\n%016llx\n", (unsigned long long)assetid, owner.value ? owner.to_string().c_str() : ".", (unsigned long long)p.mask );
+		for( const auto& s : p.siblings )
+			printf( "%s\n", to_hex( s ).c_str() );
+		fprintf( stderr, "root %s\n", to_hex( t.root() ).c_str() );
+		return 0;
+	}
+
+	int verify( const std::string& root_hex ) {
+		checksum256 root;
+		if ( !from_hex( root_hex, root ) ) {
+			fprintf( stderr, "bad root\n" );
+			return 2;
+		}
+
+		uint64_t assetid;
+		std::string owner, mask;
+		if ( !( std::cin >> assetid >> owner >> mask ) ) {
+			fprintf( stderr, "bad proof\n" );
+			return 2;
+		}
+
+		merkle::proof p;
+		p.mask = std::stoull( mask, nullptr, 16 );
+		for( std::string line; std::cin >> line; ) {
+			checksum256 s;
+			if ( !from_hex( line, s ) ) {
+				fprintf( stderr, "bad proof\n" );
+				return 2;
+			}
+			p.siblings.push_back( s );
+		}
+
+		name o = owner == "." ? name() : name( owner );
+		bool ok = merkle::verify( root, assetid, o, p );
+		printf( "%s\n", ok ? "valid" : "invalid" );
+		return ok ? 0 : 1;
+	}
+
+	int usage() {
+		fprintf( stderr,
+			"usage: saproof root <store>\n"
+			"       saproof prove <store> <assetid>\n"
+			"       saproof verify <root> < proof\n" );
+		return 2;
+	}
+}
+
+int main( int argc, char** argv ) {
+	std::vector<std::string> args( argv + 1, argv + argc );
+
+	try {
+		if ( args.size() == 2 && args[0] == "root" ) {
+			store db( args[1] );
+			printf( "%s\n", to_hex( load( db ).root() ).c_str() );
+			return 0;
+		}
+		if ( args.size() == 3 && args[0] == "prove" )
+			return prove( args[1], std::stoull( args[2] ) );
+		if ( args.size() == 2 && args[0] == "verify" )
+			return verify( args[1] );
+	} catch( const std::exception& e ) {
+		fprintf( stderr, "error: %s\n", e.what() );
+		return 1;
+	}
+	return usage();
+}
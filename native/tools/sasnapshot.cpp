@@ -0,0 +1,181 @@
+/**
+ *  SimpleAssets (Digital Assets)
+ *  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+ *
+ *  sasnapshot - bootstraps a local store (see simpleassets/store.hpp) from a nodeos snapshot.
+ *
+ *  Extracts the SimpleAssets tables (sassets, offers, offerfs, delegates, accounts, stat,
+ *  authors, global, offersto, offerfsto, accshards) of all scopes from the contract_tables section. Table boundaries are found
+ *  in one sequential pass over the mapped file; rows of each table are then decoded and
+ *  validated on worker threads and written to the store in snapshot order. The store gets
+ *  the snapshot block number, so `saindex ingest` continues from the next block.
+ *
+ *  Usage:
+ *    sasnapshot <snapshot.bin> <store> [-c contract] [-t threads]
+ */
+
+#include <simpleassets/snapshot.hpp>
+#include <simpleassets/store.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace simpleassets;
+
+namespace {
+
+	struct extracted_row {
+		uint64_t			pk;
+		name				payer;
+		std::string_view	value;
+	};
+
+	struct job {
+		table_id					id;
+		snapshot::table				table;
+		std::vector<extracted_row>	rows;
+		std::string					error;
+	};
+
+	template<typename T>
+	void check_value( std::string_view value ) {
+		T v;
+		decode( value, v );
+	}
+
+	void check_row( table_id id, std::string_view value ) {
+		switch( id ) {
+			case table_id::sassets:		check_value<sasset_view>( value );			break;
+			case table_id::offers:		check_value<soffer_view>( value );			break;
+			case table_id::offerfs:		check_value<sofferf_view>( value );			break;
+			case table_id::delegates:	check_value<sdelegate_view>( value );		break;
+			case table_id::accounts:	check_value<account_view>( value );			break;
+			case table_id::stat:		check_value<currency_stats_view>( value );	break;
+			case table_id::authors:		check_value<sauthor_view>( value );			break;
+			case table_id::global:		check_value<global_view>( value );			break;
+			case table_id::offersto:	check_value<soffer_view>( value );			break;
+			case table_id::offerfsto:	check_value<sofferf_view>( value );			break;
+			case table_id::accshards:	check_value<accshard_view>( value );		break;
+			default:					break;
+		}
+	}
+
+	void decode_table( job& j ) {
+		j.rows.reserve( j.table.count );
+		try {
+			snapshot::for_each_row( j.table, [&]( uint64_t pk, name payer, std::string_view value ) {
+				check_row( j.id, value );
+				j.rows.push_back( { pk, payer, value } );
+			});
+		} catch( const std::exception& e ) {
+			j.error = e.what();
+		}
+	}
+
+	int usage() {
+		fprintf( stderr, "usage: sasnapshot <snapshot.bin> <store> [-c contract] [-t threads]\n" );
+		return 2;
+	}
+}
+
+int main( int argc, char** argv ) {
+	if ( argc < 3 )
+		return usage();
+
+	name code( "simpleassets" );
+	unsigned threads = std::max( 1u, std::thread::hardware_concurrency() );
+	for( int i = 3; i + 1 < argc; i += 2 ) {
+		std::string opt = argv[i];
+		if ( opt == "-c" )		code = name( argv[i + 1] );
+		else if ( opt == "-t" )	threads = std::max( 1, atoi( argv[i + 1] ) );
+		else return usage();
+	}
+
+	auto started = std::chrono::steady_clock::now();
+
+	int fd = open( argv[1], O_RDONLY );
+	struct stat st;
+	if ( fd < 0 || fstat( fd, &st ) != 0 ) {
+		fprintf( stderr, "cannot open %s\n", argv[1] );
+		return 1;
+	}
+	void* m = mmap( nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );
+	if ( m == MAP_FAILED ) {
+		fprintf( stderr, "cannot map %s\n", argv[1] );
+		return 1;
+	}
+	madvise( m, st.st_size, MADV_SEQUENTIAL );
+	std::string_view file( (const char*)m, st.st_size );
+
+	try {
+		store db( argv[2] );
+		if ( db.size() ) {
+			fprintf( stderr, "store %s is not empty\n", argv[2] );
+			return 1;
+		}
+
+		// pass 1: section and table boundaries
+		uint32_t block = 0;
+		std::vector<job> jobs;
+		size_t skipped = 0;
+
+		snapshot::for_each_section( file, [&]( const snapshot::section& s ) {
+			if ( s.name == "eosio::chain::block_state" && s.rows ) {
+				block = snapshot::block_num( s );
+			} else if ( s.name == "contract_tables" ) {
+				snapshot::for_each_table( s.data, code, [&]( const snapshot::table& t ) {
+					table_id id;
+					if ( table_from_name( t.table, id ) )
+						jobs.push_back( { id, t, {}, {} } );
+					else
+						++skipped;
+				});
+			}
+		});
+
+		// pass 2: decode tables in parallel
+		std::atomic<size_t> next{ 0 };
+		std::vector<std::thread> workers;
+		for( unsigned i = 0; i < threads; ++i ) {
+			workers.emplace_back( [&] {
+				for( size_t j; ( j = next++ ) < jobs.size(); )
+					decode_table( jobs[j] );
+			});
+		}
+		for( auto& w : workers )
+			w.join();
+
+		// pass 3: write in snapshot order
+		size_t rows = 0;
+		for( const auto& j : jobs ) {
+			if ( !j.error.empty() ) {
+				fprintf( stderr, "bad row in %s/%s: %s\n", j.table.scope.to_string().c_str(), j.table.table.to_string().c_str(), j.error.c_str() );
+				return 1;
+			}
+			for( const auto& r : j.rows )
+				db.upsert( j.id, j.table.scope, r.pk, r.payer, r.value );
+			rows += j.rows.size();
+		}
+
+		db.set_last_block( block );
+		db.checkpoint();
+
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now() - started ).count();
+		fprintf( stderr, "block %u: %zu tables, %zu rows written, %zu other tables of %s skipped (%lld ms)\n",
+			block, jobs.size(), rows, skipped, code.to_string().c_str(), (long long)ms );
+	} catch( const std::exception& e ) {
+		fprintf( stderr, "error: %s\n", e.what() );
+		return 1;
+	}
+
+	munmap( m, st.st_size );
+	return 0;
+}
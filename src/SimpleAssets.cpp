@@ -22,6 +22,91 @@ ACTION SimpleAssets::updatever( string version ) {
 	configs.set(tokenconfigs{"simpleassets"_n, version}, _self);	
 }
 
+ACTION SimpleAssets::setevents( uint32_t capacity, bool deferred ) {
+	require_auth(get_self());
+
+	evconf config(_self, _self.value);
+	evconfig ec = config.exists() ? config.get() : evconfig{};
+
+	check( capacity == 0 || capacity >= ec.allocated, "capacity can not be below the number of slots in use" );
+
+	ec.capacity = capacity;
+	ec.deferred = deferred;
+	config.set(ec, _self);
+}
+
+ACTION SimpleAssets::migrate( uint32_t limit ) {
+	require_auth(get_self());
+
+	offers offert(_self, _self.value);
+	for ( auto itr = offert.begin(); limit > 0 && itr != offert.end(); --limit ) {
+		addOffer( _self, *itr );
+		countRows( "offers"_n, -1, -2 * rowBytes( *itr ) );
+		itr = offert.erase( itr );
+	}
+
+	offerfs offerft(_self, _self.value);
+	for ( auto itr = offerft.begin(); limit > 0 && itr != offerft.end(); --limit ) {
+		addOfferf( _self, *itr );
+		countRows( "offerfs"_n, -1, -2 * rowBytes( *itr ) );
+		itr = offerft.erase( itr );
+	}
+
+	delegates delegatet(_self, _self.value);
+	for ( auto itr = delegatet.begin(); limit > 0 && itr != delegatet.end(); --limit ) {
+		addDelegate( _self, *itr );
+		countRows( "delegates"_n, -1, -rowBytes( *itr ) );
+		itr = delegatet.erase( itr );
+	}
+
+	if ( offert.begin() == offert.end() && offerft.begin() == offerft.end() && delegatet.begin() == delegatet.end() ) {
+		conf config(_self, _self.value);
+		_cstate = config.exists() ? config.get() : global{};
+		_cstate.spare1 = 1;
+		config.set(_cstate, _self);
+	}
+}
+
+ACTION SimpleAssets::setmerkle() {
+	require_auth(get_self());
+	check( !merkleOn(), "ownership commitment is already enabled" );
+
+	_mstate.enabled = true;
+	merkleconf config(_self, _self.value);
+	config.set(_mstate, _self);
+}
+
+ACTION SimpleAssets::merklesync( name owner, std::vector<uint64_t>& assetids ) {
+	check( merkleOn(), "ownership commitment is not enabled" );
+
+	sassets assets_f( _self, owner.value );
+	for( size_t i = 0; i < assetids.size(); ++i ) {
+		check( assets_f.find( assetids[i] ) != assets_f.end(), "At least one of the assets cannot be found." );
+		merkleSet( assetids[i], owner );
+	}
+	merkleCommit();
+}
+
+ACTION SimpleAssets::setstats( name table, int64_t rows, int64_t bytes ) {
+	require_auth(get_self());
+	check( table == "sassets"_n || table == "offers"_n || table == "offerfs"_n || table == "delegates"_n, "unknown table" );
+
+	tablestats stats_(_self, _self.value);
+	auto itr = stats_.find( table.value );
+	if ( itr == stats_.end() ) {
+		stats_.emplace( _self, [&]( auto& s ) {
+			s.table = table;
+			s.rows = rows;
+			s.bytes = bytes;
+		});
+	} else {
+		stats_.modify( itr, same_payer, [&]( auto& s ) {
+			s.rows = rows;
+			s.bytes = bytes;
+		});
+	}
+}
+
 ACTION SimpleAssets::regauthor( name author, string data, string stemplate) {
 
 	require_auth( author );
@@ -83,17 +168,16 @@ ACTION SimpleAssets::create( name author, name category, name owner, string idat
 	if (requireclaim){
 		assetOwner = author;
 		//add info to offers table
-		offers offert(_self, _self.value);
-		offert.emplace( author, [&]( auto& s ) {     
-			s.assetid = newID;
-			s.offeredto = owner;
-			s.owner = author;
-			s.cdate = now();
-		});
+		soffer o;
+		o.assetid = newID;
+		o.offeredto = owner;
+		o.owner = author;
+		o.cdate = now();
+		addOffer( author, o );
 	}
 	
 	sassets assets(_self, assetOwner.value);
-	assets.emplace( author, [&]( auto& s ) {     
+	auto itr = assets.emplace( author, [&]( auto& s ) {     
 		s.id = newID;
 		s.owner = assetOwner;
 		s.author = author;
@@ -101,10 +185,21 @@ ACTION SimpleAssets::create( name author, name category, name owner, string idat
 		s.mdata = mdata; // mutable data
 		s.idata = idata; // immutable data
 	});
+	countRows( "sassets"_n, 1, rowBytes( *itr ) );
 	
+	merkleSet( newID, assetOwner );
+	merkleCommit();
+
 	//Events
-	sendEvent(author, author, "saecreate"_n, std::make_tuple(owner, newID));
-	SEND_INLINE_ACTION( *this, createlog, { {_self, "active"_n} },  { author, category, owner, idata, mdata, newID, requireclaim}   );
+	logEvent( "saecreate"_n, author, author, owner, { newID } );
+	if ( deferEvents() )
+		sendEvent(author, author, "saecreate"_n, std::make_tuple(owner, newID));
+	// digest of idata and mdata as serialized in this action's data, see createlogh
+	auto data = pack( std::make_tuple( idata, mdata ) );
+	checksum256 datahash = sha256( data.data(), data.size() );
+
+	SA_COUNT( inlines );
+	SEND_INLINE_ACTION( *this, createlogh, { {_self, "active"_n} },  { author, category, owner, newID, requireclaim, datahash }   );
 }
 
 
@@ -113,19 +208,57 @@ ACTION SimpleAssets::createlog( name author, name category, name owner, string i
 }
 
 
+ACTION SimpleAssets::createlogh( name author, name category, name owner, uint64_t assetid, bool requireclaim, checksum256 datahash ) {
+	require_auth(get_self());
+}
+
+
+ACTION SimpleAssets::createdrop( name author, name category, name owner, string idata, string mdata, uint64_t count ) {
+
+	require_auth( author );
+	check( is_account( owner ), "owner account does not exist");
+	check( count > 0 && count <= 1000000, "count must be between 1 and 1000000" );
+
+	require_recipient( owner );
+
+	uint64_t first = getid(false, count);
+
+	drops drops_(_self, owner.value);
+	drops_.emplace( author, [&]( auto& d ) {
+		d.last = first + count - 1;
+		d.first = first;
+		d.author = author;
+		d.category = category;
+		d.owner = owner;
+		d.left = count;
+		d.done.resize( ( ( count + dropchunk - 1 ) / dropchunk + 7 ) / 8 );		// sized up front, materialize never grows the row
+		d.idata = idata;
+		d.mdata = mdata;
+	});
+
+	SA_COUNT( inlines );
+	SEND_INLINE_ACTION( *this, droplog, { {_self, "active"_n} },  { author, owner, first, first + count - 1 }   );
+}
+
+
+ACTION SimpleAssets::droplog( name author, name owner, uint64_t first, uint64_t last ) {
+	require_auth(get_self());
+}
+
+
 ACTION SimpleAssets::claim( name claimer, std::vector<uint64_t>& assetids) {
 	require_auth( claimer );
 	require_recipient( claimer );
 	
-	offers offert(_self, _self.value);
 	sassets assets_t(_self, claimer.value);
 	
-	std::map< name, std::map< uint64_t, name > > uniqauthor;
+	saarena::map< name, saarena::map< uint64_t, name > > uniqauthor;
 	for( size_t i = 0; i < assetids.size(); ++i ) {
 
-		auto itrc = offert.find( assetids[i] );
+		auto oc = findOfferTo( claimer, assetids[i] );
+		const auto* itrc = &oc.row;
 
-		check(itrc != offert.end(), "Cannot find at least one of the assets you're attempting to claim.");
+		check(oc.found, "Cannot find at least one of the assets you're attempting to claim.");
 		check(claimer == itrc->offeredto, "At least one of the assets has not been offerred to you.");
 
 		sassets assets_f( _self, itrc->owner.value );
@@ -134,34 +267,107 @@ ACTION SimpleAssets::claim( name claimer, std::vector<uint64_t>& assetids) {
 
 		check(itrc->owner.value == itr->owner.value, "Owner was changed for at least one of the items!?");   
 
-		assets_t.emplace( claimer, [&]( auto& s ) {     
-			s.id = itr->id;
-			s.owner = claimer;
-			s.author = itr->author;
-			s.category = itr->category;		
-			s.mdata = itr->mdata; 		// mutable data
-			s.idata = itr->idata; 		// immutable data
-			s.container = itr->container;
-			s.containerf = itr->containerf;
-		});
-
-		assets_f.erase(itr);
-		offert.erase(itrc);
-
 		//Events
 		uniqauthor[itr->author][assetids[i]] = itrc->owner;
+
+		moveAsset( assets_f, itr, assets_t, claimer, claimer );
+		eraseOffer( oc );
+		merkleSet( assetids[i], claimer );
 	}
 
+	merkleCommit();
+
 	//Send Event as deferred	
 	auto uniqauthorIt = uniqauthor.begin(); 
 	while(uniqauthorIt != uniqauthor.end() ) {
 		name keyauthor = (*uniqauthorIt).first; 
-		sendEvent(keyauthor, claimer, "saeclaim"_n, std::make_tuple(claimer, uniqauthor[keyauthor]));
+
+		saarena::map< name, saarena::vector<uint64_t> > byowner;
+		for ( const auto& ao : uniqauthorIt->second )
+			byowner[ao.second].push_back( ao.first );
+		for ( const auto& ow : byowner )
+			logEvent( "saeclaim"_n, keyauthor, ow.first, claimer, ow.second );
+
+		if ( deferEvents() )
+			sendEvent(keyauthor, claimer, "saeclaim"_n, std::make_tuple(claimer, uniqauthor[keyauthor]));
 		uniqauthorIt++;
 	}
 }
 
 
+struct SimpleAssets::transferpolicy {
+	static constexpr bool	row			= true;
+	static constexpr bool	events		= true;
+	static constexpr lookup	offer		= lookup::absent;
+	static constexpr lookup	delegate	= lookup::load;
+	static constexpr bool	lazy		= true;
+	static constexpr bool	expire		= true;
+
+	static constexpr const char* notfound	= "At least one of the assets cannot be found (check ids?)";
+	static constexpr const char* offered	= "At least one of the assets has been offered for a claim and cannot be transferred. Cancel offer?";
+	static constexpr const char* delegated	= "";
+
+	SimpleAssets&				sa;
+	name						holder;
+	name						to;
+	name						rampayer;
+	sassets&					assets_t;
+	const string&				memo;
+	const rowref<sapproval>&	approval;		// operator who signed instead of holder
+	name						authed = {};
+
+	// holder, an approved operator or the owner of the delegation must have signed
+	void authorize( const batchitem& b ) {
+		name signer = holder;
+		if ( b.delegate.found && has_auth( b.delegate.row.owner ) )
+			signer = b.delegate.row.owner;
+		if ( signer == holder && approval.found ) {
+			check( approves( approval.row, b.itr->author ), "The operator is not approved for at least one of the assets." );
+			signer = approval.row.op;
+		}
+		if ( signer != authed ) {
+			require_auth( signer );
+			authed = signer;
+		}
+	}
+
+	// a transfer back to the owner of the delegation returns the asset itself, with its memo.
+	// A returned row is paid by the signer (owner of the delegation, holder or operator), never
+	// by the recipient
+	name reclaimer( const batchitem& b ) {
+		if ( b.delegate.row.owner == to )
+			return name{};
+		authorize( b );
+		return authed;
+	}
+
+	void validate( const batchitem& b ) {
+		if ( b.delegate.found ) {
+			const auto& d = b.delegate.row;
+			check ( d.owner == to || d.delegatedto == to, "At least one of the assets cannot be transferred because it is delegated" );
+		}
+		authorize( b );
+
+		check(holder.value == b.itr->owner.value, "At least one of the assets is not yours to transfer.");   
+	}
+
+	void apply( sassets& assets_f, const batchitem& b ) {
+		if ( b.delegate.found && b.delegate.row.owner == to )
+			sa.eraseDelegate( b.delegate );
+
+		sa.moveAsset( assets_f, b.itr, assets_t, to, rampayer );
+		sa.merkleSet( b.id, to );
+	}
+
+	void finish( sassets& ) {}
+
+	void event( name author, const saarena::vector<uint64_t>& ids ) {
+		sa.logEvent( "saetransfer"_n, author, holder, to, ids );
+		if ( sa.deferEvents() )
+			sa.sendEvent(author, rampayer, "saetransfer"_n, std::make_tuple(holder, to, ids, memo) );
+	}
+};
+
 ACTION SimpleAssets::transfer( name from, name to, std::vector<uint64_t>& assetids, string memo){
 	
 	check( from != to, "cannot transfer to yourself" );
@@ -173,75 +379,17 @@ ACTION SimpleAssets::transfer( name from, name to, std::vector<uint64_t>& asseti
 		
 	sassets assets_f( _self, from.value );
 	sassets assets_t(_self, to.value);
-	
-	delegates delegatet(_self, _self.value);
-	offers offert(_self, _self.value);
-
-	auto rampayer = has_auth( to ) ? to : from;
-		
-	bool isDelegeting = false;
-	
-	std::map< name, std::vector<uint64_t> > uniqauthor;
-	
-	for( size_t i = 0; i < assetids.size(); ++i ) {
-		auto itrd = delegatet.find( assetids[i] );
-
-		isDelegeting = false;
-		if (itrd != delegatet.end()){
-			auto dg = *itrd;
-			if (itrd->owner == to || itrd->delegatedto == to){
-				isDelegeting = true;		
-				if (itrd->owner == to)
-					delegatet.erase(itrd);
-			} else {
-				check ( false, "At least one of the assets cannot be transferred because it is delegated" );	
-			}
-		}
-		
-		if (isDelegeting){
-			require_auth( has_auth( itrd->owner  ) ? itrd->owner  : from);
-			
-		} else {
-			require_auth( from );
-		}
-
-	
-		auto itr = assets_f.find( assetids[i] );
-		check(itr != assets_f.end(), "At least one of the assets cannot be found (check ids?)");
-
-		check(from.value == itr->owner.value, "At least one of the assets is not yours to transfer.");   
 
-		auto itrc = offert.find( assetids[i] );
-		check ( itrc == offert.end(), "At least one of the assets has been offered for a claim and cannot be transferred. Cancel offer?" );
+	rowref<sapproval> approval;
+	if ( !has_auth( from ) )
+		approval = findOperator( from );
 
-		assets_f.erase(itr);
-	
-		assets_t.emplace( rampayer, [&]( auto& s ) {     
-			s.id = itr->id;
-			s.owner = to;
-			s.author = itr->author;
-			s.category = itr->category;		
-			s.idata = itr->idata; 		// immutable data
-			s.mdata = itr->mdata; 		// mutable data
-			s.container = itr->container;
-			s.containerf = itr->containerf;
+	auto rampayer = has_auth( to ) ? to : approval.found ? approval.row.op : from;
 
-		});
-		
-		//Events
-		uniqauthor[itr->author].push_back(assetids[i]);		
-	}
-	
-	//Send Event as deferred
-	auto uniqauthorIt = uniqauthor.begin(); 
-	while(uniqauthorIt != uniqauthor.end() ) {
-		name keyauthor = (*uniqauthorIt).first; 
-		sendEvent(keyauthor, rampayer, "saetransfer"_n, std::make_tuple(from, to, uniqauthor[keyauthor], memo) );
-		uniqauthorIt++;
-	}
+	transferpolicy p{ *this, from, to, rampayer, assets_t, memo, approval };
+	batch( p, assets_f, assetids );
 }
 
-
 ACTION SimpleAssets::update( name author, name owner, uint64_t assetid, string mdata ) {
 	
 	require_auth( author );
@@ -249,9 +397,13 @@ ACTION SimpleAssets::update( name author, name owner, uint64_t assetid, string m
 	sassets assets_f( _self, owner.value );
 
 	auto itr = assets_f.find( assetid );
+	if ( itr == assets_f.end() )
+		itr = materialize( assets_f, owner, assetid, author );
 	check(itr != assets_f.end(), "asset not found");
+	merkleCommit();
 
 	check(itr->author == author, "Only author can update asset.");
+	countRows( "sassets"_n, 0, int64_t( mdata.size() ) - int64_t( itr->mdata.size() ) );
 	
 	assets_f.modify( itr, author, [&]( auto& a ) {
         a.mdata = mdata;
@@ -259,6 +411,42 @@ ACTION SimpleAssets::update( name author, name owner, uint64_t assetid, string m
 }
 
 
+struct SimpleAssets::offerpolicy {
+	static constexpr bool	row			= true;
+	static constexpr bool	events		= false;
+	static constexpr lookup	offer		= lookup::absent;
+	static constexpr lookup	delegate	= lookup::absent;
+	static constexpr bool	lazy		= true;
+	static constexpr bool	expire		= true;
+
+	static constexpr const char* notfound	= "At least one of the assets was not found.";
+	static constexpr const char* offered	= "At least one of the assets is already offered for claim.";
+	static constexpr const char* delegated	= "At least one of the assets is delegated and cannot be offered.";
+
+	SimpleAssets&	sa;
+	name			holder;
+	name			rampayer;
+	name			newowner;
+
+	name reclaimer( const batchitem& b ) {		// holder signed
+		return has_auth( b.delegate.row.owner ) ? b.delegate.row.owner : holder;
+	}
+
+	void validate( const batchitem& b ) {}
+
+	void apply( sassets& assets_f, const batchitem& b ) {
+		soffer o;
+		o.assetid = b.id;
+		o.offeredto = newowner;
+		o.owner = holder;
+		o.cdate = now();
+		sa.addOffer( holder, o );
+	}
+
+	void finish( sassets& ) {}
+	void event( name, const saarena::vector<uint64_t>& ) {}
+};
+
 ACTION SimpleAssets::offer( name owner, name newowner, std::vector<uint64_t>& assetids, string memo){
 
 	check( owner != newowner, "cannot offer to yourself" );
@@ -270,86 +458,231 @@ ACTION SimpleAssets::offer( name owner, name newowner, std::vector<uint64_t>& as
 	check( is_account( newowner ), "newowner account does not exist");
 	
 	sassets assets_f( _self, owner.value );
-	offers offert(_self, _self.value);
-	delegates delegatet(_self, _self.value);	
-		
-	for( size_t i = 0; i < assetids.size(); ++i ) {
-		auto itr = assets_f.find( assetids[i] );
-		check(itr != assets_f.end(), "At least one of the assets was not found.");
 
-		auto itrc = offert.find( assetids[i] );
-		check ( itrc == offert.end(), "At least one of the assets is already offered for claim." );
+	offerpolicy p{ *this, owner, owner, newowner };
+	batch( p, assets_f, assetids );
+}
 
-		auto itrd = delegatet.find( assetids[i] );
-		check ( itrd == delegatet.end(), "At least one of the assets is delegated and cannot be offered." );
-		
-		offert.emplace( owner, [&]( auto& s ) {     
-			s.assetid = assetids[i];
-			s.offeredto = newowner;
-			s.owner = owner;
-			s.cdate = now();
-		});
+
+struct SimpleAssets::cancelofferpolicy {
+	static constexpr bool	row			= false;
+	static constexpr bool	events		= false;
+	static constexpr lookup	offer		= lookup::load;
+	static constexpr lookup	delegate	= lookup::skip;
+	static constexpr bool	lazy		= false;
+	static constexpr bool	expire		= false;
+
+	static constexpr const char* notfound	= "";
+	static constexpr const char* offered	= "";
+	static constexpr const char* delegated	= "";
+
+	SimpleAssets&	sa;
+	name			holder;
+
+	void validate( const batchitem& b ) {
+		check ( b.offer.found, "The offer for at least one of the assets was not found." );
+		check (holder.value == b.offer.row.owner.value, "You're not the owner of at least one of the assets whose offers you're attempting to cancel.");
+	}
+
+	void apply( sassets& assets_f, const batchitem& b ) {
+		sa.eraseOffer( b.offer );
 	}
-}
 
+	void finish( sassets& ) {}
+	void event( name, const saarena::vector<uint64_t>& ) {}
+};
 
 ACTION SimpleAssets::canceloffer( name owner, std::vector<uint64_t>& assetids){
 
 	require_auth( owner );
 	require_recipient( owner );
-	
-	offers offert(_self, _self.value);
 
-	for( size_t i = 0; i < assetids.size(); ++i ) {
-		auto itr = offert.find( assetids[i] );
+	sassets assets_f( _self, owner.value );
+
+	cancelofferpolicy p{ *this, owner };
+	batch( p, assets_f, assetids );
+}
+
+
+struct SimpleAssets::burnpolicy {
+	static constexpr bool	row			= true;
+	static constexpr bool	events		= true;
+	static constexpr lookup	offer		= lookup::absent;
+	static constexpr lookup	delegate	= lookup::absent;
+	static constexpr bool	lazy		= true;
+	static constexpr bool	expire		= true;
+
+	static constexpr const char* notfound	= "At least one of the assets was not found.";
+	static constexpr const char* offered	= "At least one of the assets has an open offer and cannot be burned.";
+	static constexpr const char* delegated	= "At least one of assets is delegated and cannot be burned.";
 
-		check ( itr != offert.end(), "The offer for at least one of the assets was not found." );
-		check (owner.value == itr->owner.value, "You're not the owner of at least one of the assets whose offers you're attempting to cancel.");
+	SimpleAssets&	sa;
+	name			holder;
+	name			rampayer;
+	const string&	memo;
 
-		offert.erase(itr);
+	name reclaimer( const batchitem& b ) {		// holder signed
+		return has_auth( b.delegate.row.owner ) ? b.delegate.row.owner : holder;
 	}
-}
 
+	void validate( const batchitem& b ) {
+		check(holder.value == b.itr->owner.value, "At least one of the assets you're attempting to burn is not yours.");
+	}
+
+	void apply( sassets& assets_f, const batchitem& b ) {
+		sa.countRows( "sassets"_n, -1, -rowBytes( *b.itr ) );
+		assets_f.erase( b.itr );
+		sa.merkleSet( b.id, name{} );
+	}
+
+	void finish( sassets& ) {}
+
+	void event( name author, const saarena::vector<uint64_t>& ids ) {
+		sa.logEvent( "saeburn"_n, author, holder, name{}, ids );
+		if ( sa.deferEvents() )
+			sa.sendEvent(author, holder, "saeburn"_n, std::make_tuple(holder, ids, memo));
+	}
+};
 
 ACTION SimpleAssets::burn( name owner, std::vector<uint64_t>& assetids, string memo ) {
 
 	require_auth( owner );	
 
 	sassets assets_f( _self, owner.value );
-	offers offert(_self, _self.value);
-	delegates delegatet(_self, _self.value);
-		
-	std::map< name, std::vector<uint64_t> > uniqauthor;
-	
-	for( size_t i = 0; i < assetids.size(); ++i ) {
-		
-		auto itr = assets_f.find( assetids[i] );
-		check(itr != assets_f.end(), "At least one of the assets was not found.");
 
-		check(owner.value == itr->owner.value, "At least one of the assets you're attempting to burn is not yours.");
+	burnpolicy p{ *this, owner, owner, memo };
+	batch( p, assets_f, assetids );
+}
 
-		auto itrc = offert.find( assetids[i] );
-		check ( itrc == offert.end(), "At least one of the assets has an open offer and cannot be burned." );
+ACTION SimpleAssets::transferall( name from, name to, name author, name category, uint64_t cursor, uint32_t limit, string memo ){
+
+	check( from != to, "cannot transfer to yourself" );
+	check( is_account( to ), "TO account does not exist");
+	check( memo.size() <= 256, "memo has more than 256 bytes" );
+	check( limit > 0, "limit must be positive" );
+
+	require_auth( from );
+	require_recipient( from );
+	require_recipient( to );
+
+	sassets assets_f( _self, from.value );
+	sassets assets_t(_self, to.value);
+
+	auto rampayer = has_auth( to ) ? to : from;
+	uint32_t count = 0;
+
+	saarena::map< name, saarena::vector<uint64_t> > uniqauthor;
+
+	auto itr = assets_f.lower_bound( cursor );
+	for( ; limit > 0 && itr != assets_f.end(); --limit ) {
+		if ( bulkSkip( from, *itr, author, category ) ) {
+			itr++;
+			continue;
+		}
+
+		merkleSet( itr->id, to );
 
-		auto itrd = delegatet.find( assetids[i] );
-		check ( itrd == delegatet.end(), "At least one of assets is delegated and cannot be burned." );
-		
-		assets_f.erase(itr);
-		
 		//Events
-		uniqauthor[itr->author].push_back(assetids[i]);
+		uniqauthor[itr->author].push_back(itr->id);
+		count++;
+		itr = moveAsset( assets_f, itr, assets_t, to, rampayer );
 	}
-	
+	uint64_t nextcursor = itr == assets_f.end() ? 0 : itr->id;
+	merkleCommit();
+
 	//Send Event as deferred
-	auto uniqauthorIt = uniqauthor.begin(); 
-	while(uniqauthorIt != uniqauthor.end() ) {
-		name keyauthor = (*uniqauthorIt).first; 
-		sendEvent(keyauthor, owner, "saeburn"_n, std::make_tuple(owner, uniqauthor[keyauthor], memo));
-		uniqauthorIt++;
+	for ( const auto& ua : uniqauthor ) {
+		logEvent( "saetransfer"_n, ua.first, from, to, ua.second );
+		if ( deferEvents() )
+			sendEvent(ua.first, rampayer, "saetransfer"_n, std::make_tuple(from, to, ua.second, memo) );
+	}
+
+	SA_COUNT( inlines );
+	SEND_INLINE_ACTION( *this, bulklog, { {_self, "active"_n} },  { from, "transferall"_n, nextcursor, count }   );
+}
+
+
+ACTION SimpleAssets::burnall( name owner, name author, name category, uint64_t cursor, uint32_t limit, string memo ){
+
+	check( memo.size() <= 256, "memo has more than 256 bytes" );
+	check( limit > 0, "limit must be positive" );
+
+	require_auth( owner );
+
+	sassets assets_f( _self, owner.value );
+	uint32_t count = 0;
+
+	saarena::map< name, saarena::vector<uint64_t> > uniqauthor;
+
+	auto itr = assets_f.lower_bound( cursor );
+	for( ; limit > 0 && itr != assets_f.end(); --limit ) {
+		if ( bulkSkip( owner, *itr, author, category ) ) {
+			itr++;
+			continue;
+		}
+
+		merkleSet( itr->id, name{} );
+		countRows( "sassets"_n, -1, -rowBytes( *itr ) );
+
+		//Events
+		uniqauthor[itr->author].push_back(itr->id);
+		count++;
+		itr = assets_f.erase(itr);
 	}
+	uint64_t nextcursor = itr == assets_f.end() ? 0 : itr->id;
+	merkleCommit();
+
+	//Send Event as deferred
+	for ( const auto& ua : uniqauthor ) {
+		logEvent( "saeburn"_n, ua.first, owner, name{}, ua.second );
+		if ( deferEvents() )
+			sendEvent(ua.first, owner, "saeburn"_n, std::make_tuple(owner, ua.second, memo));
+	}
+
+	SA_COUNT( inlines );
+	SEND_INLINE_ACTION( *this, bulklog, { {_self, "active"_n} },  { owner, "burnall"_n, nextcursor, count }   );
 }
 
 
+ACTION SimpleAssets::bulklog( name owner, name type, uint64_t nextcursor, uint32_t count ) {
+	require_auth(get_self());
+}
+
+
+struct SimpleAssets::delegatepolicy {
+	static constexpr bool	row			= true;
+	static constexpr bool	events		= false;
+	static constexpr lookup	offer		= lookup::absent;
+	static constexpr lookup	delegate	= lookup::absent;
+	static constexpr bool	lazy		= true;
+	static constexpr bool	expire		= false;
+
+	static constexpr const char* notfound	= "At least one of the assets cannot be found.";
+	static constexpr const char* offered	= "At least one of the assets has an open offer and cannot be delegated.";
+	static constexpr const char* delegated	= "At least one of the assets is already delegated.";
+
+	SimpleAssets&	sa;
+	name			holder;
+	name			rampayer;
+	name			to;
+	uint64_t		period;
+
+	void validate( const batchitem& b ) {}
+
+	void apply( sassets& assets_f, const batchitem& b ) {
+		sdelegate d;
+		d.assetid = b.id;
+		d.owner = holder;
+		d.delegatedto = to;
+		d.cdate = now();
+		d.period = period;
+		sa.addDelegate( holder, d );
+	}
+
+	void finish( sassets& ) {}
+	void event( name, const saarena::vector<uint64_t>& ) {}
+};
+
 ACTION SimpleAssets::delegate( name owner, name to, std::vector<uint64_t>& assetids, uint64_t period, string memo ){
 
 	check( owner != to, "cannot delegate to yourself" );
@@ -360,107 +693,283 @@ ACTION SimpleAssets::delegate( name owner, name to, std::vector<uint64_t>& asset
 	check( is_account( to ), "TO account does not exist");
 
 	sassets assets_f( _self, owner.value );
-	delegates delegatet(_self, _self.value);
-	offers offert(_self, _self.value);
-
-	string assetidsmemo = "";
-	
-	for( size_t i = 0; i < assetids.size(); ++i ) {
-		
-		auto itr = assets_f.find( assetids[i] );
-		check(itr != assets_f.end(), "At least one of the assets cannot be found.");
-		
 
-		auto itrd = delegatet.find( assetids[i] );
-		check ( itrd == delegatet.end(), "At least one of the assets is already delegated." );
+	delegatepolicy p{ *this, owner, owner, to, period };
+	batch( p, assets_f, assetids );
 
-		auto itro = offert.find( assetids[i] );
-		check ( itro == offert.end(), "At least one of the assets has an open offer and cannot be delegated." );
-		
-		delegatet.emplace( owner, [&]( auto& s ) {     
-			s.assetid = assetids[i];
-			s.owner = owner;
-			s.delegatedto = to;
-			s.cdate = now();
-			s.period = period;
-		});
-		
-	}
 	string newmemo = "Delegate memo: "+memo;
+	SA_COUNT( inlines );
 	SEND_INLINE_ACTION( *this, transfer, { {owner, "active"_n} },  { owner, to, assetids, newmemo}   );
 }
 
 
-ACTION SimpleAssets::undelegate( name owner, name from, std::vector<uint64_t>& assetids ){
-
-	require_auth( owner );
-	require_recipient( owner );
-	
-	check( is_account( from ), "to account does not exist");
+struct SimpleAssets::undelegatepolicy {
+	static constexpr bool	row			= true;
+	static constexpr bool	events		= false;
+	static constexpr lookup	offer		= lookup::skip;
+	static constexpr lookup	delegate	= lookup::load;
+	static constexpr bool	lazy		= false;
+	static constexpr bool	expire		= false;
 
-	sassets assets_f( _self, from.value );
-	delegates delegatet(_self, _self.value);
+	static constexpr const char* notfound	= "At least one of the assets cannot be found.";
+	static constexpr const char* offered	= "";
+	static constexpr const char* delegated	= "";
 
-	string assetidsmemo = "";	
-	for( size_t i = 0; i < assetids.size(); ++i ) {
-		
-		auto itr = assets_f.find( assetids[i] );
-		check(itr != assets_f.end(), "At least one of the assets cannot be found.");
+	SimpleAssets&	sa;
+	name			holder;
+	name			owner;
+	bool			listids;
+	string			assetidsmemo = "";
 
-		auto itrc = delegatet.find( assetids[i] );
-		check ( itrc != delegatet.end(), "At least one of the assets is not delegated." );
+	void validate( const batchitem& b ) {
+		const auto* itrc = &b.delegate.row;
+		check ( b.delegate.found, "At least one of the assets is not delegated." );
 
 		check(owner == itrc->owner, "You are not the owner of at least one of these assets.");
-		check(from == itrc->delegatedto, "FROM does not match DELEGATEDTO for at least one of the assets.");   
-		check(itr->owner == itrc->delegatedto, "FROM does not match DELEGATEDTO for at least one of the assets.");   		
+		check(holder == itrc->delegatedto, "FROM does not match DELEGATEDTO for at least one of the assets.");   
+		check(b.itr->owner == itrc->delegatedto, "FROM does not match DELEGATEDTO for at least one of the assets.");   		
 		check( (itrc->cdate + itrc->period) < now(), "Cannot undelegate until the PERIOD expires.");   		
-			
-		if (i != 0) assetidsmemo += ", ";
-		assetidsmemo += std::to_string(assetids[i]);
 	}
-	
-	SEND_INLINE_ACTION( *this, transfer, { {owner, "active"_n} },  { from, owner, assetids, "undelegate assetid: "+assetidsmemo }   );
+
+	void apply( sassets& assets_f, const batchitem& b ) {
+		if ( !listids )
+			return;
+		if ( !assetidsmemo.empty() ) assetidsmemo += ", ";
+		assetidsmemo += std::to_string( b.id );
+	}
+
+	void finish( sassets& ) {}
+	void event( name, const saarena::vector<uint64_t>& ) {}
+};
+
+ACTION SimpleAssets::undelegate( name owner, name from, std::vector<uint64_t>& assetids ){
+	undelegateIds( owner, from, assetids, "" );
 }
 
 
-ACTION SimpleAssets::attach( name owner, uint64_t assetidc, std::vector<uint64_t>& assetids ){
+struct SimpleAssets::attachpolicy {
+	static constexpr bool	row			= true;
+	static constexpr bool	events		= false;
+	static constexpr lookup	offer		= lookup::absent;
+	static constexpr lookup	delegate	= lookup::absent;
+	static constexpr bool	lazy		= true;
+	static constexpr bool	expire		= false;		// only the author signs: delegated assets are refused
 
-	sassets assets_f( _self, owner.value );
-	delegates delegatet(_self, _self.value);
-	offers offert(_self, _self.value);
+	static constexpr const char* notfound	= "At least one of the assets cannot be found.";
+	static constexpr const char* offered	= "At least one of the assets has an open offer and cannot be delegated.";
+	static constexpr const char* delegated	= "At least one of the assets is delegated.";
 
-	require_recipient( owner );
+	SimpleAssets&				sa;
+	name						holder;
+	name						rampayer;
+	sassets::const_iterator		ac;
+	saarena::vector< sassets::const_iterator > moved = {};
 
-	auto ac_ = assets_f.find( assetidc );
-	check(ac_ != assets_f.end(), "Asset cannot be found.");
-	const auto& ac = *ac_;
+	void validate( const batchitem& b ) {
+		check(ac->id != b.id, "Cannot attcach to self.");
+		check(b.itr->author == ac->author, "Different authors.");
+	}
 
-	require_auth( ac_->author );
-	
-	for( size_t i = 0; i < assetids.size(); ++i ) {
-		
-		auto itr = assets_f.find( assetids[i] );
-		check(itr != assets_f.end(), "At least one of the assets cannot be found.");
+	void apply( sassets& assets_f, const batchitem& b ) {
+		moved.push_back( b.itr );
+	}
+
+	// one container update for the whole batch; the cached rows are destroyed by the erase
+	// below, so their data is moved, not copied
+	void finish( sassets& assets_f ) {
+		if ( moved.empty() )
+			return;
+
+		assets_f.modify( ac, ac->author, [&]( auto& a ) {
+			for ( auto itr : moved )
+				a.container.push_back( std::move( const_cast<sasset&>( *itr ) ) );
+		});
+
+		for ( auto itr : moved ) {
+			uint64_t id = itr->id;
+			assets_f.erase( itr );
+			sa.merkleSet( id, name{} );
+			sa.countRows( "sassets"_n, -1, -112 );		// row data moved into the container
+		}
+	}
+
+	void event( name, const saarena::vector<uint64_t>& ) {}
+};
+
+struct SimpleAssets::reclaimpolicy {
+	static constexpr bool	row			= true;
+	static constexpr bool	events		= false;
+	static constexpr lookup	offer		= lookup::skip;
+	static constexpr lookup	delegate	= lookup::load;
+	static constexpr bool	lazy		= false;
+	static constexpr bool	expire		= true;
+
+	static constexpr const char* notfound	= "At least one of the assets cannot be found.";
+	static constexpr const char* offered	= "";
+	static constexpr const char* delegated	= "";
+
+	SimpleAssets&	sa;
+	name			holder;
+	name			rampayer;		// owner of the delegations
+
+	name reclaimer( const batchitem& b ) {
+		check( rampayer == b.delegate.row.owner, "You are not the owner of at least one of these assets." );
+		return rampayer;
+	}
+
+	// expired delegations never get here, the engine returns them
+	void validate( const batchitem& b ) {
+		check ( b.delegate.found, "At least one of the assets is not delegated." );
+		check( false, "Cannot undelegate until the PERIOD expires." );
+	}
+
+	void apply( sassets& assets_f, const batchitem& b ) {}
+	void finish( sassets& ) {}
+	void event( name, const saarena::vector<uint64_t>& ) {}
+};
+
+ACTION SimpleAssets::reclaim( name owner, name from, std::vector<uint64_t>& assetids ){
+
+	require_auth( owner );
+	require_recipient( owner );
+	require_recipient( from );
+
+	sassets assets_f( _self, from.value );
+
+	reclaimpolicy p{ *this, from, owner };
+	batch( p, assets_f, assetids );
+}
+
+
+ACTION SimpleAssets::approve( name owner, name op, name author ){
+
+	require_auth( owner );
+	require_recipient( op );
+
+	check( owner != op, "cannot approve yourself" );
+	check( is_account( op ), "operator account does not exist");
+
+	approvals approvals_(_self, owner.value);
+	auto itr = approvals_.find( op.value );
+	if ( itr == approvals_.end() ) {
+		approvals_.emplace( owner, [&]( auto& a ) {
+			a.op = op;
+			if ( author )
+				a.authors.push_back( author );
+		});
+		return;
+	}
+
+	check( !approves( *itr, author ), "already approved" );
+	approvals_.modify( itr, owner, [&]( auto& a ) {
+		if ( author )
+			a.authors.push_back( author );
+		else
+			a.authors.clear();
+	});
+}
+
+
+ACTION SimpleAssets::revoke( name owner, name op, name author ){
 
-		check(assetidc != assetids[i], "Cannot attcach to self.");
+	require_auth( owner );
 
-		const auto& itr_ = *itr;	
+	approvals approvals_(_self, owner.value);
+	auto itr = approvals_.find( op.value );
+	check( itr != approvals_.end(), "operator is not approved" );
 
-		check(itr_.author == ac.author, "Different authors.");
-		auto itrd = delegatet.find( assetids[i] );
-		check ( itrd == delegatet.end(), "At least one of the assets is delegated." );
+	if ( !author ) {
+		approvals_.erase( itr );
+		return;
+	}
 
-		auto itro = offert.find( assetids[i] );
-		check ( itro == offert.end(), "At least one of the assets has an open offer and cannot be delegated." );
+	check( !itr->authors.empty(), "operator is approved for all authors, revoke with an empty author" );
+	auto it = std::find( itr->authors.begin(), itr->authors.end(), author );
+	check( it != itr->authors.end(), "operator is not approved for this author" );
 
-		assets_f.modify( ac_, ac.author, [&]( auto& a ) {				
-			a.container.push_back(itr_);
+	if ( itr->authors.size() == 1 ) {
+		approvals_.erase( itr );
+	} else {
+		size_t pos = it - itr->authors.begin();
+		approvals_.modify( itr, owner, [&]( auto& a ) {
+			a.authors.erase( a.authors.begin() + pos );
 		});
-		assets_f.erase(itr);
 	}
 }
 
 
+//-----------------------------------------------------------------
+// Range variants of the batch actions
+
+ACTION SimpleAssets::transferr( name from, name to, std::vector<idrange>& ranges, string memo ){
+	auto assetids = expandRanges( ranges );
+	transfer( from, to, assetids, memo );
+}
+
+
+ACTION SimpleAssets::burnr( name owner, std::vector<idrange>& ranges, string memo ){
+	auto assetids = expandRanges( ranges );
+	burn( owner, assetids, memo );
+}
+
+
+ACTION SimpleAssets::offerr( name owner, name newowner, std::vector<idrange>& ranges, string memo ){
+	auto assetids = expandRanges( ranges );
+	offer( owner, newowner, assetids, memo );
+}
+
+
+ACTION SimpleAssets::cancelofferr( name owner, std::vector<idrange>& ranges ){
+	auto assetids = expandRanges( ranges );
+	canceloffer( owner, assetids );
+}
+
+
+ACTION SimpleAssets::claimr( name claimer, std::vector<idrange>& ranges ){
+	auto assetids = expandRanges( ranges );
+	claim( claimer, assetids );
+}
+
+
+ACTION SimpleAssets::delegater( name owner, name to, std::vector<idrange>& ranges, uint64_t period, string memo ){
+	auto assetids = expandRanges( ranges );
+	delegate( owner, to, assetids, period, memo );
+}
+
+
+ACTION SimpleAssets::undelegater( name owner, name from, std::vector<idrange>& ranges ){
+	auto assetids = expandRanges( ranges );
+
+	string memo = "undelegate assetids: ";
+	for( size_t i = 0; i < ranges.size(); ++i ) {
+		if (i != 0) memo += ", ";
+		memo += std::to_string( ranges[i].first );
+		if ( ranges[i].count > 1 )
+			memo += "-" + std::to_string( ranges[i].first + ranges[i].count - 1 );
+	}
+	if ( memo.size() > 256 )
+		memo = memo.substr( 0, 253 ) + "...";		// transfer memo limit
+	undelegateIds( owner, from, assetids, memo );
+}
+
+
+ACTION SimpleAssets::attach( name owner, uint64_t assetidc, std::vector<uint64_t>& assetids ){
+
+	sassets assets_f( _self, owner.value );
+
+	require_recipient( owner );
+
+	auto ac_ = assets_f.find( assetidc );
+	if ( ac_ == assets_f.end() )
+		ac_ = materialize( assets_f, owner, assetidc, name{} );
+	check(ac_ != assets_f.end(), "Asset cannot be found.");
+
+	require_auth( ac_->author );
+
+	attachpolicy p{ *this, owner, ac_->author, ac_ };
+	batch( p, assets_f, assetids );
+}
+
 ACTION SimpleAssets::detach( name owner, uint64_t assetidc, std::vector<uint64_t>& assetids ){
 	
 	require_auth( owner );
@@ -470,45 +979,51 @@ ACTION SimpleAssets::detach( name owner, uint64_t assetidc, std::vector<uint64_t
 		
 	auto ac_ = assets_f.find( assetidc );
 	check(ac_ != assets_f.end(), "Asset cannot be found.");
-	const auto& ac = *ac_;
 		
 	for( size_t i = 0; i < assetids.size(); ++i ) {
-		std::vector<sasset> newcontainer;
-		
-		for( size_t j = 0; j < ac.container.size(); ++j ) {
-			auto acc = ac.container[j];
-			if ( assetids[i] == acc.id){
-				 
-				assets_f.emplace( owner, [&]( auto& s ) {     
-					s.id = acc.id;
-					s.owner = acc.owner;
-					s.author = acc.author;
-					s.category = acc.category;		
-					s.idata = acc.idata; 		// immutable data
-					s.mdata = acc.mdata; 		// mutable data
-					s.container = acc.container;
-					s.containerf = acc.containerf;
-				});
-				
-			} else {
-				newcontainer.push_back(acc);
-			}		
-		}
-		
+		sasset detached;
+		bool found = false;
+
 		assets_f.modify( ac_, owner, [&]( auto& a ) {
-			a.container = newcontainer;
+			for( auto it = a.container.begin(); it != a.container.end(); ++it ) {
+				if ( assetids[i] == it->id ) {
+					detached = std::move( *it );
+					a.container.erase( it );
+					found = true;
+					break;
+				}
+			}
 		});
+
+		if ( found ) {
+			assets_f.emplace( owner, [&]( auto& s ) {     
+				s = std::move( detached );
+			});
+			merkleSet( assetids[i], owner );
+			countRows( "sassets"_n, 1, 112 );
+		}
 	}	
+	merkleCommit();
 }
 
 
 ACTION SimpleAssets::attachf( name owner, name author, asset quantity, uint64_t assetidc ){
-	attachdeatch( owner, author, quantity, assetidc, true );
+	attachdeatch( owner, { { assetidc, author, quantity } }, true );
 }
 
 
 ACTION SimpleAssets::detachf( name owner, name author, asset quantity, uint64_t assetidc ){
-	attachdeatch( owner, author, quantity, assetidc, false );
+	attachdeatch( owner, { { assetidc, author, quantity } }, false );
+}
+
+
+ACTION SimpleAssets::attachfs( name owner, std::vector<ftentry>& entries ){
+	attachdeatch( owner, entries, true );
+}
+
+
+ACTION SimpleAssets::detachfs( name owner, std::vector<ftentry>& entries ){
+	attachdeatch( owner, entries, false );
 }
 	
 
@@ -581,6 +1096,7 @@ ACTION SimpleAssets::issuef( name to, name author, asset quantity, string memo )
 	add_balancef( st.issuer, author, quantity, st.issuer );
 
 	if( to != st.issuer ) {
+		SA_COUNT( inlines );
 		SEND_INLINE_ACTION( *this, transferf, { {st.issuer, "active"_n} },
 			{ st.issuer, to, author, quantity, memo }
 		);
@@ -616,70 +1132,45 @@ ACTION SimpleAssets::transferf( name from, name to, name author, asset quantity,
 	require_auth( checkAuth );	
 
 	sub_balancef( from, author, quantity );
-	add_balancef( to, author, quantity, payer );
+	add_balancef( to, author, quantity, payer, from );
 }
 
 
 ACTION SimpleAssets::offerf( name owner, name newowner, name author, asset quantity, string memo){
+	offerFts( owner, { { newowner, author, quantity, memo } } );
+}
 
-	require_auth( owner );
-	require_recipient( owner );
-	require_recipient( newowner );
-
-	check( is_account( newowner ), "newowner account does not exist");
-	check( owner != newowner, "cannot offer to yourself" );
-
-	auto sym = quantity.symbol;
-	check( sym.is_valid(), "invalid symbol name" );
-	check( memo.size() <= 256, "memo has more than 256 bytes" );
-
-	stats statstable( _self, author.value );
-	auto existing = statstable.find( sym.code().raw() );
-	check( existing != statstable.end(), "token with symbol does not exist" );
-	const auto& st = *existing;
-		
-	check( quantity.is_valid(), "invalid quantity" );
-	check( quantity.amount > 0, "must retire positive quantity" );
-
-	check( quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
-
-	offerfs offert(_self, _self.value);
-	auto owner_index = offert.template get_index<"owner"_n>();
-	auto itro = owner_index.find( owner.value );
 
-	for (; itro != owner_index.end(); itro++) {
-		check(  !(itro->author == author && itro->offeredto == newowner && itro->quantity.symbol == quantity.symbol ), "Such an offer already exists");		
-	}
-	
-	offert.emplace( owner, [&]( auto& s ) {     
-		s.id = getid(true);
-		s.author = author;
-		s.quantity = quantity; 
-		s.offeredto = newowner;
-		s.owner = owner;
-		s.cdate = now();
-	});
-	sub_balancef( owner, author, quantity );
+ACTION SimpleAssets::offerfbatch( name owner, std::vector<ftoffer>& offers ){
+	offerFts( owner, offers );
 }
 
 
 ACTION SimpleAssets::cancelofferf( name owner, std::vector<uint64_t>& ftofferids){
 	require_auth( owner );
 	require_recipient( owner );
-	
-	offerfs offert(_self, _self.value);
 
+	saarena::map< std::pair<name, uint64_t>, asset > totals;		// (author, symbol) -> returned quantity
+	
 	for( size_t i = 0; i < ftofferids.size(); ++i ) {
 
 		uint64_t offtid = ftofferids[i];
-		auto itr = offert.find( offtid );
-
-		check ( itr != offert.end(), "The offer for at least one of the FT was not found." );
-		check (owner.value == itr->owner.value, "You're not the owner of at least one of those FTs.");
+		auto oc = findOfferf( owner, offtid );
+
+		check ( oc.found, "The offer for at least one of the FT was not found." );
+		check (owner.value == oc.row.owner.value, "You're not the owner of at least one of those FTs.");
+
+		auto key = std::make_pair( oc.row.author, oc.row.quantity.symbol.raw() );
+		auto tk = totals.find( key );
+		if ( tk == totals.end() )
+			totals.emplace( key, oc.row.quantity );
+		else
+			tk->second += oc.row.quantity;
+		eraseOfferf( oc );
+	}
 
-		add_balancef( owner, itr->author, itr->quantity, owner );
-		offert.erase(itr);
-	}	
+	for( const auto& tk : totals )
+		add_balancef( owner, tk.first.first, tk.second, owner );
 }
 
 ACTION SimpleAssets::claimf( name claimer, std::vector<uint64_t>& ftofferids) {
@@ -687,20 +1178,18 @@ ACTION SimpleAssets::claimf( name claimer, std::vector<uint64_t>& ftofferids) {
 	require_auth( claimer );
 	require_recipient( claimer );
 	
-	offerfs offert(_self, _self.value);
-	
-	std::map< name, std::vector<uint64_t> > uniqauthor;
+	saarena::map< name, saarena::vector<uint64_t> > uniqauthor;
 		
 	for( size_t i = 0; i < ftofferids.size(); ++i ) {
 		uint64_t offtid = ftofferids[i];
 	
-		auto itrc = offert.find( offtid );
+		auto oc = findOfferfTo( claimer, offtid );
 
-		check(itrc != offert.end(), "Cannot find at least one of the FT you're attempting to claim.");
-		check(claimer == itrc->offeredto, "At least one of the FTs has not been offerred to you.");
+		check(oc.found, "Cannot find at least one of the FT you're attempting to claim.");
+		check(claimer == oc.row.offeredto, "At least one of the FTs has not been offerred to you.");
 
-		add_balancef( claimer, itrc->author, itrc->quantity, claimer );
-		offert.erase(itrc);
+		add_balancef( claimer, oc.row.author, oc.row.quantity, claimer, oc.row.owner );
+		eraseOfferf( oc );
 	}
 }
 
@@ -752,6 +1241,8 @@ ACTION SimpleAssets::openf( name owner, name author, const symbol& symbol, name
 			a.author = author;
 			a.balance = asset{0, symbol};
 		});
+		if ( ( ram_payer == author || ram_payer == _self ) && reclaimOn( author, symbol.code() ) )
+			markZerof( owner, ftid, ram_payer );
 	}
 }
 
@@ -764,16 +1255,108 @@ ACTION SimpleAssets::closef( name owner, name author, const symbol& symbol ){
 	
 	auto it = acnts.find( ftid );
 	check( it != acnts.end(), "Balance row already deleted or never existed. Action won't have any effect." );
-	check( it->balance.amount == 0, "Cannot close because the balance is not zero." );
+	check( it->balance.amount == 0 && shardBalance( owner, ftid, false ) == 0, "Cannot close because the balance is not zero." );
 	
-	offerfs offert(_self, _self.value);
-	auto owner_index = offert.template get_index<"owner"_n>();
-	auto itro = owner_index.find( owner.value );
-	for (; itro != owner_index.end(); itro++) {
-		check(  !(itro->author == author && itro->quantity.symbol == symbol ), "You have open offers for this FT..");		
-	}
+	check( !hasOfferf( owner, author, symbol, name{} ), "You have open offers for this FT.." );
 	
 	acnts.erase( it );
+	markZerof( owner, ftid, name{} );
+}
+
+
+ACTION SimpleAssets::setshards( name owner, uint8_t shards ){
+	require_auth( owner );
+	check( shards == 0 || ( shards >= 2 && shards <= 16 ), "shards must be 0 or 2..16" );
+
+	ftshards shards_(_self, _self.value);
+	auto itr = shards_.find( owner.value );
+	if ( shards == 0 ) {
+		check( itr != shards_.end(), "Balances of this account are not sharded." );
+		shards_.erase( itr );
+	} else if ( itr == shards_.end() ) {
+		shards_.emplace( owner, [&]( auto& s ) {
+			s.owner = owner;
+			s.shards = shards;
+		});
+	} else {
+		shards_.modify( itr, owner, [&]( auto& s ) {
+			s.shards = shards;
+		});
+	}
+}
+
+
+ACTION SimpleAssets::consolidate( name owner, name author, const symbol& symbol ){
+	uint64_t ftid = getFTIndex( author, symbol );
+
+	int64_t amount = shardBalance( owner, ftid, true );
+	check( amount > 0, "No balance shards to consolidate." );
+
+	accounts acnts( _self, owner.value );
+	auto it = acnts.find( ftid );
+	if ( it == acnts.end() ) {
+		require_auth( owner );
+		acnts.emplace( owner, [&]( auto& a ){
+			a.id = ftid;
+			a.author = author;
+			a.balance = asset{ amount, symbol };
+		});
+	} else {
+		acnts.modify( it, same_payer, [&]( auto& a ) {
+			a.balance.amount += amount;
+		});
+	}
+}
+
+
+ACTION SimpleAssets::setreclaim( name author, symbol_code sym, bool on ){
+	require_auth( author );
+
+	if ( sym.raw() != 0 ) {
+		stats statstable( _self, author.value );
+		check( statstable.find( sym.raw() ) != statstable.end(), "token with symbol does not exist." );
+	}
+
+	reclaimfs reclaim_(_self, author.value);
+	auto itr = reclaim_.find( sym.raw() );
+	if ( on ) {
+		check( itr == reclaim_.end(), "Reclamation is already on." );
+		reclaim_.emplace( author, [&]( auto& r ) {
+			r.sym = sym;
+		});
+	} else {
+		check( itr != reclaim_.end(), "Reclamation is not on." );
+		reclaim_.erase( itr );
+	}
+}
+
+
+ACTION SimpleAssets::sweepf( name author, symbol_code sym, std::vector<name>& owners ){
+	require_auth( author );
+	check( owners.size() <= 200, "at most 200 accounts per sweep" );
+	check( reclaimOn( author, sym ), "Reclamation is not on for this token." );
+
+	stats statstable( _self, author.value );
+	const auto& st = statstable.get( sym.raw(), "token with symbol does not exist." );
+
+	for ( auto owner : owners ) {
+		zerofs zero_( _self, owner.value );
+		auto z = zero_.find( st.id );
+		if ( z == zero_.end() )
+			continue;		// not billed to the author or the contract
+
+		accounts acnts( _self, owner.value );
+		auto it = acnts.find( st.id );
+		if ( it == acnts.end() || it->balance.amount != 0 )
+			continue;
+		accshards shards( _self, owner.value );
+		auto s = shards.lower_bound( st.id << 4 );
+		if ( ( s != shards.end() && ( s->key >> 4 ) == st.id ) || hasOfferf( owner, author, st.supply.symbol, name{} ) )
+			continue;
+
+		acnts.erase( it );
+		zero_.erase( z );
+	}
 }
 
 
@@ -786,25 +1369,69 @@ ACTION SimpleAssets::closef( name owner, name author, const symbol& symbol ){
 * getid private action
 * Increment, save and return id for a new asset or new fungible token.
 */
-uint64_t SimpleAssets::getid(bool defer){
+uint64_t SimpleAssets::getid(bool defer, uint64_t count){
 
 	conf config(_self, _self.value);
 	_cstate = config.exists() ? config.get() : global{};
+	SA_COUNT( finds );
 
 	uint64_t resid;
 	if (defer) {
-		_cstate.defid++;
-		resid = _cstate.defid;
+		resid = _cstate.defid + 1;
+		_cstate.defid += count;
 	} else {
-		_cstate.lnftid++;
-		resid = _cstate.lnftid;
+		resid = _cstate.lnftid + 1;
+		_cstate.lnftid += count;
 	}
 
 	config.set(_cstate, _self);
+	SA_COUNT( updates );
 	return resid;
 }
 
 
+/*
+* Asset ids of the {first, count} runs, in the order given.
+*/
+std::vector<uint64_t> SimpleAssets::expandRanges( const std::vector<idrange>& ranges ) {
+	uint64_t total = 0;
+	for ( const auto& r : ranges ) {
+		check( r.count > 0, "range count must be positive" );
+		check( r.first + r.count > r.first, "range overflows" );
+		total += r.count;
+	}
+	check( total <= 10000, "at most 10000 assets per action" );
+
+	std::vector<uint64_t> assetids;
+	assetids.reserve( total );
+	for ( const auto& r : ranges ) {
+		for ( uint64_t id = r.first; id < r.first + r.count; ++id )
+			assetids.push_back( id );
+	}
+	return assetids;
+}
+
+
+/*
+* undelegate / undelegater. An empty memo lists every asset id in the memo of the inline transfer.
+*/
+void SimpleAssets::undelegateIds( name owner, name from, std::vector<uint64_t>& assetids, const string& memo ){
+
+	require_auth( owner );
+	require_recipient( owner );
+	
+	check( is_account( from ), "to account does not exist");
+
+	sassets assets_f( _self, from.value );
+
+	undelegatepolicy p{ *this, from, owner, memo.empty() };
+	batch( p, assets_f, assetids );
+	
+	SA_COUNT( inlines );
+	SEND_INLINE_ACTION( *this, transfer, { {owner, "active"_n} },  { from, owner, assetids, memo.empty() ? "undelegate assetid: "+p.assetidsmemo : memo }   );
+}
+
+
 uint64_t SimpleAssets::getFTIndex(name author, symbol symbol){
 
 	stats statstable( _self, author.value );
@@ -818,107 +1445,269 @@ uint64_t SimpleAssets::getFTIndex(name author, symbol symbol){
 	return res;
 }
 
-void SimpleAssets::attachdeatch( name owner, name author, asset quantity, uint64_t assetidc, bool attach ){	
-
-	sassets assets_f( _self, owner.value );
-	delegates delegatet(_self, _self.value);
-	offers offert(_self, _self.value);
-	stats statstable( _self, author.value );
+/*
+* attachf / detachf and their batch versions. Entries are grouped by token (one stats read and
+* one balance change each) and by NFT (one find, one offer / delegation check, one modify each).
+*/
+void SimpleAssets::attachdeatch( name owner, const std::vector<ftentry>& entries, bool attach ){	
 
-	auto sym = quantity.symbol.code();
-	const auto& st = statstable.get( sym.raw() );
+	check( !entries.empty(), "no entries" );
 
 	require_recipient( owner );
 
-	check( quantity.is_valid(), "invalid quantity" );
-	check( quantity.amount > 0, "must transfer positive quantity" );
-	check( quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
-
-	check( st.issuer == author, "Different authors");
-
-	if (attach) {
-		require_auth( author );	 //attach
-	} else {
+	if (!attach) {
 		require_auth( owner );  //deatach
 	}
 
-	auto itr = assets_f.find( assetidc );
-	check(itr != assets_f.end(), "assetid cannot be found.");
-	
-	const auto& ac = *itr;	
-	
-	check(ac.author == author, "Different authors.");
-	auto itrd = delegatet.find( assetidc );
-	check ( itrd == delegatet.end(), "Asset is delegated." );
+	struct ftsum {
+		uint64_t	id;
+		asset		total;
+	};
+	saarena::map< std::pair<name, uint64_t>, ftsum > tokens;		// (author, symbol code)
+	saarena::map< uint64_t, saarena::vector<const ftentry*> > byasset;
 
-	auto itro = offert.find( assetidc );
-	check ( itro == offert.end(), "Assets has an open offer and cannot be delegated." );
+	for( const auto& e : entries ) {
+		check( e.quantity.is_valid(), "invalid quantity" );
+		check( e.quantity.amount > 0, "must transfer positive quantity" );
 
-	std::vector<account> newcontainerf;
+		auto key = std::make_pair( e.author, e.quantity.symbol.code().raw() );
+		auto tk = tokens.find( key );
+		if ( tk == tokens.end() ) {
+			stats statstable( _self, e.author.value );
+			const auto& st = statstable.get( key.second );
+
+			check( e.quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
+			check( st.issuer == e.author, "Different authors");
 
-	bool found = false;
-	
-	for( size_t j = 0; j < ac.containerf.size(); j++ ) {
-		auto accf = ac.containerf[j];
-		if ( st.id == accf.id){
 			if (attach) {
-				accf.balance.amount += quantity.amount;
-			} else {
-				check( accf.balance.amount >= quantity.amount, "overdrawn balance" );   
-				accf.balance.amount -= quantity.amount;  
+				require_auth( e.author );	 //attach
 			}
-		
-			found = true;
-		} 
-		if (accf.balance.amount > 0) 
-			newcontainerf.push_back(accf);
-	}
-	
-	if (!found && attach){
-		account addft;
-		addft.id = st.id;
-		addft.author = author;
-		addft.balance = quantity;
+			tk = tokens.emplace( key, ftsum{ st.id, asset( 0, st.supply.symbol ) } ).first;
+		}
+		check( e.quantity.symbol == tk->second.total.symbol, "symbol precision mismatch" );
+		tk->second.total += e.quantity;
 
-		newcontainerf.push_back(addft);
+		byasset[e.assetidc].push_back( &e );
 	}
-	
-	if (!attach)
-		check (found, "not attached");   
-	
-	assets_f.modify( itr, author, [&]( auto& a ) {
-		a.containerf = newcontainerf;
-	});
+
+	sassets assets_f( _self, owner.value );
+
+	for( const auto& ba : byasset ) {
+		uint64_t assetidc = ba.first;
+
+		auto itr = assets_f.find( assetidc );
+		if ( itr == assets_f.end() && attach )
+			itr = materialize( assets_f, owner, assetidc, name{} );		// paid by the author, who signed
+		check(itr != assets_f.end(), "assetid cannot be found.");
+
+		check ( !findDelegate( owner, assetidc ).found, "Asset is delegated." );
+		check ( !findOffer( owner, assetidc ).found, "Assets has an open offer and cannot be delegated." );
+
+		for( const auto* e : ba.second )
+			check(itr->author == e->author, "Different authors.");
+
+		bool found = true;
 		
-	if (attach) {	
-		sub_balancef( owner, author, quantity );
-	} else {
-		add_balancef( owner, author, quantity, owner ); 
+		assets_f.modify( itr, itr->author, [&]( auto& a ) {
+			for( const auto* e : ba.second ) {
+				uint64_t ftid = tokens[std::make_pair( e->author, e->quantity.symbol.code().raw() )].id;
+				auto it = a.containerf.begin();
+				for( ; it != a.containerf.end() && it->id != ftid; ++it );
+
+				if ( it == a.containerf.end() ) {
+					if (attach) {
+						account addft;
+						addft.id = ftid;
+						addft.author = e->author;
+						addft.balance = e->quantity;
+
+						a.containerf.push_back(addft);
+					} else {
+						found = false;
+					}
+					continue;
+				}
+
+				if (attach) {
+					it->balance.amount += e->quantity.amount;
+				} else {
+					check( it->balance.amount >= e->quantity.amount, "overdrawn balance" );   
+					it->balance.amount -= e->quantity.amount;  
+				}
+				if ( it->balance.amount <= 0 )
+					a.containerf.erase( it );
+			}
+		});
+
+		check (found, "not attached");   
+	}
+
+	for( const auto& tk : tokens ) {
+		if (attach) {	
+			sub_balancef( owner, tk.first.first, tk.second.total );
+		} else {
+			add_balancef( owner, tk.first.first, tk.second.total, owner ); 
+		}
 	}
+
+	merkleCommit();		// materialized editions
 }
 
-void SimpleAssets::sub_balancef( name owner, name author, asset value ) {
+/*
+* offerf and offerfbatch. Duplicates are checked against the owner's open offers, read in one
+* pass, and against the offers before them in the batch; ids are reserved with one getid.
+*/
+void SimpleAssets::offerFts( name owner, const std::vector<ftoffer>& offers ){
 
-	accounts from_acnts( _self, owner.value );
-	uint64_t ftid = getFTIndex(author, value.symbol);
-	
-	const auto& from = from_acnts.get( ftid, "no balance object found" );
-	check( from.balance.amount >= value.amount, "overdrawn balance" );
+	require_auth( owner );
+	require_recipient( owner );
 
-	check( value.symbol.code().raw() == from.balance.symbol.code().raw(), "Wrong symbol");
-	auto payer = has_auth( author ) ? author : owner;
-	
-	from_acnts.modify( from, payer, [&]( auto& a ) {
-		a.balance -= value;
-	});
-}
+	check( !offers.empty(), "no offers" );
 
+	// (author, symbol, offeredto) of the open offers, sorted
+	saarena::vector< std::tuple<name, uint64_t, name> > open;
+	offerfsown offero(_self, owner.value);
+	for ( const auto& o : offero )
+		open.emplace_back( o.author, o.quantity.symbol.raw(), o.offeredto );
 
-void SimpleAssets::add_balancef( name owner, name author, asset value, name ram_payer ) {
-	
-	accounts to_acnts( _self, owner.value );
-	
-	uint64_t ftid = getFTIndex(author, value.symbol);
+	if ( hasLegacy() ) {
+		offerfs offert(_self, _self.value);
+		auto owner_index = offert.template get_index<"owner"_n>();
+		for ( auto itro = owner_index.find( owner.value ); itro != owner_index.end() && itro->owner == owner; itro++ )
+			open.emplace_back( itro->author, itro->quantity.symbol.raw(), itro->offeredto );
+	}
+	std::sort( open.begin(), open.end() );
+
+	saarena::map< std::pair<name, uint64_t>, asset > totals;		// (author, symbol code) -> offered quantity
+
+	for( const auto& f : offers ) {
+		require_recipient( f.newowner );
+
+		check( is_account( f.newowner ), "newowner account does not exist");
+		check( owner != f.newowner, "cannot offer to yourself" );
+
+		auto sym = f.quantity.symbol;
+		check( sym.is_valid(), "invalid symbol name" );
+		check( f.memo.size() <= 256, "memo has more than 256 bytes" );
+
+		auto key = std::make_pair( f.author, sym.code().raw() );
+		auto tk = totals.find( key );
+		if ( tk == totals.end() ) {
+			stats statstable( _self, f.author.value );
+			auto existing = statstable.find( sym.code().raw() );
+			check( existing != statstable.end(), "token with symbol does not exist" );
+
+			tk = totals.emplace( key, asset( 0, existing->supply.symbol ) ).first;
+		}
+			
+		check( f.quantity.is_valid(), "invalid quantity" );
+		check( f.quantity.amount > 0, "must retire positive quantity" );
+
+		check( sym == tk->second.symbol, "symbol precision mismatch" );
+
+		auto o = std::make_tuple( f.author, sym.raw(), f.newowner );
+		auto pos = std::lower_bound( open.begin(), open.end(), o );
+		check( pos == open.end() || *pos != o, "Such an offer already exists" );
+		open.insert( pos, o );
+
+		tk->second += f.quantity;
+	}
+
+	uint64_t id = getid( true, offers.size() );
+	for( const auto& f : offers ) {
+		sofferf o;
+		o.id = id++;
+		o.author = f.author;
+		o.quantity = f.quantity; 
+		o.offeredto = f.newowner;
+		o.owner = owner;
+		o.cdate = now();
+		addOfferf( owner, o );
+	}
+
+	for( const auto& tk : totals )
+		sub_balancef( owner, tk.first.first, tk.second );
+}
+
+
+void SimpleAssets::sub_balancef( name owner, name author, asset value ) {
+
+	accounts from_acnts( _self, owner.value );
+	uint64_t ftid = getFTIndex(author, value.symbol);
+	auto payer = has_auth( author ) ? author : owner;
+
+	// a sharded balance is consolidated only when the accounts row alone does not cover the debit
+	auto from = from_acnts.find( ftid );
+	if ( from == from_acnts.end() || from->balance.amount < value.amount ) {
+		int64_t amount = shardBalance( owner, ftid, true );
+		if ( amount > 0 && from == from_acnts.end() ) {
+			from = from_acnts.emplace( payer, [&]( auto& a ){
+				a.id = ftid;
+				a.author = author;
+				a.balance = asset{ amount, value.symbol };
+			});
+		} else if ( amount > 0 ) {
+			from_acnts.modify( from, same_payer, [&]( auto& a ) {
+				a.balance.amount += amount;
+			});
+		}
+	}
+
+	check( from != from_acnts.end(), "no balance object found" );
+	check( from->balance.amount >= value.amount, "overdrawn balance" );
+
+	check( value.symbol.code().raw() == from->balance.symbol.code().raw(), "Wrong symbol");
+
+	// the row would now be billed to the author: drop it instead if the author asked for that
+	bool zero = from->balance.amount == value.amount;
+	bool reclaim = zero && payer == author && reclaimOn( author, value.symbol.code() );
+	if ( reclaim && !hasOfferf( owner, author, value.symbol, name{} ) ) {
+		from_acnts.erase( from );
+		markZerof( owner, ftid, name{} );
+		return;
+	}
+	
+	from_acnts.modify( from, payer, [&]( auto& a ) {
+		a.balance -= value;
+	});
+	if ( zero )
+		markZerof( owner, ftid, reclaim ? author : name{} );
+}
+
+
+/*
+* Credits `owner`. If `owner` has sharded balances (see setshards) and the credit comes from
+* another account, it goes to the shard picked by `from`, so every sender always writes the
+* same row and different senders mostly write different ones.
+*/
+void SimpleAssets::add_balancef( name owner, name author, asset value, name ram_payer, name from ) {
+	
+	uint64_t ftid = getFTIndex(author, value.symbol);
+
+	if ( from && from != owner ) {
+		ftshards shards_(_self, _self.value);
+		auto cfg = shards_.find( owner.value );
+		if ( cfg != shards_.end() ) {
+			uint64_t shard = ( from.value * 0x9E3779B97F4A7C15ull >> 32 ) % cfg->shards;
+			uint64_t key = ftid << 4 | shard;
+
+			accshards shards( _self, owner.value );
+			auto s = shards.find( key );
+			if ( s == shards.end() ) {
+				shards.emplace( ram_payer, [&]( auto& a ){
+					a.key = key;
+					a.balance = value;
+				});
+			} else {
+				shards.modify( s, same_payer, [&]( auto& a ) {
+					a.balance += value;
+				});
+			}
+			return;
+		}
+	}
+
+	accounts to_acnts( _self, owner.value );
 	auto to = to_acnts.find( ftid );
 	
 	if( to == to_acnts.end() ) {
@@ -934,6 +1723,52 @@ void SimpleAssets::add_balancef( name owner, name author, asset value, name ram_
 	}
 }
 
+
+/*
+* True if zero balance rows of author's token `sym` are reclaimed (see setreclaim).
+*/
+bool SimpleAssets::reclaimOn( name author, symbol_code sym ) {
+	reclaimfs reclaim_(_self, author.value);
+	return reclaim_.find( sym.raw() ) != reclaim_.end() || reclaim_.find( 0 ) != reclaim_.end();
+}
+
+
+/*
+* Records who pays for owner's zero balance row of token `ftid` (see zerofs): `payer` - the
+* author or the contract, with reclamation on, the marker is added at its expense; empty - the
+* owner or another account, or the row is gone, the marker is removed.
+*/
+void SimpleAssets::markZerof( name owner, uint64_t ftid, name payer ) {
+	zerofs zero_( _self, owner.value );
+	auto z = zero_.find( ftid );
+	if ( payer && z == zero_.end() ) {
+		zero_.emplace( payer, [&]( auto& r ) {
+			r.id = ftid;
+		});
+	} else if ( !payer && z != zero_.end() ) {
+		zero_.erase( z );
+	}
+}
+
+
+/*
+* Sum of the balance shards of token `ftid` held by `owner`; `erase` also frees the shard rows
+* (consolidation, the caller adds the sum to the accounts row).
+*/
+int64_t SimpleAssets::shardBalance( name owner, uint64_t ftid, bool erase ) {
+	accshards shards( _self, owner.value );
+
+	int64_t amount = 0;
+	for ( auto s = shards.lower_bound( ftid << 4 ); s != shards.end() && ( s->key >> 4 ) == ftid; ) {
+		amount += s->balance.amount;
+		if ( erase )
+			s = shards.erase( s );
+		else
+			++s;
+	}
+	return amount;
+}
+
 template<typename... Args>
 void SimpleAssets::sendEvent(name author, name rampayer, name seaction, const std::tuple<Args...> &adata) {
 
@@ -941,20 +1776,698 @@ void SimpleAssets::sendEvent(name author, name rampayer, name seaction, const st
 	sevent.actions.emplace_back( permission_level{_self, "active"_n}, author, seaction, adata);
 	sevent.delay_sec = 0;
 	sevent.send(getid(true), rampayer);
+	SA_COUNT( deferred );
+}
+
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+/*
+* Loads the event log settings once per action.
+* Returns true if deferred event transactions should be sent.
+*/
+bool SimpleAssets::deferEvents() {
+	if ( !_evloaded ) {
+		evconf config(_self, _self.value);
+		_evstate = config.exists() ? config.get() : evconfig{};
+		_evloaded = true;
+		SA_COUNT( finds );
+	}
+	return _evstate.capacity == 0 || _evstate.deferred;
+}
+
+
+/*
+* Appends one record to the event log, overwriting the oldest slot once the log is full.
+* RAM of the log rows is paid by the contract. The sequence number is saved once per action,
+* see flushEvents.
+*/
+void SimpleAssets::logEvent( name type, name author, name from, name to, const saarena::vector<uint64_t>& assetids ) {
+	deferEvents();
+	if ( _evstate.capacity == 0 )
+		return;
+
+	events events_(_self, _self.value);
+	uint64_t slot = _evstate.nextseq % _evstate.capacity;
+
+	auto fill = [&]( auto& e ) {
+		e.slot = slot;
+		e.seq = _evstate.nextseq;
+		e.type = type;
+		e.author = author;
+		e.from = from;
+		e.to = to;
+		e.cdate = now();
+		e.assetids.assign( assetids.begin(), assetids.end() );
+	};
+
+	auto itr = events_.find( slot );
+	if ( itr != events_.end() ) {
+		events_.modify( itr, _self, fill );
+	} else {
+		events_.emplace( _self, fill );
+		_evstate.allocated = std::max( _evstate.allocated, uint32_t( slot + 1 ) );
+	}
+
+	_evstate.nextseq++;
+	_evdirty = true;
+}
+
+
+void SimpleAssets::flushEvents() {
+	if ( !_evdirty )
+		return;
+
+	evconf config(_self, _self.value);
+	config.set(_evstate, _self);
+	_evdirty = false;
+	SA_COUNT( updates );
+}
+
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+/*
+* Returns true while the self scoped offers, offerfs and delegates tables may still have rows.
+*/
+bool SimpleAssets::hasLegacy() {
+	if ( !_legacyloaded ) {
+		conf config(_self, _self.value);
+		_legacy = !config.exists() || config.get().spare1 == 0;
+		_legacyloaded = true;
+		SA_COUNT( finds );
+	}
+	return _legacy;
+}
+
+
+/*
+* Open NFT offer of an asset held by `holder`.
+*/
+SimpleAssets::rowref<SimpleAssets::soffer> SimpleAssets::findOffer( name holder, uint64_t assetid ) {
+	rowref<soffer> r;
+
+	offersown offero(_self, holder.value);
+	auto itr = offero.find( assetid );
+	if ( itr != offero.end() ) {
+		r.found = true;
+		r.row = *itr;
+	} else if ( hasLegacy() ) {
+		offers offert(_self, _self.value);
+		auto itrl = offert.find( assetid );
+		if ( itrl != offert.end() ) {
+			r.found = r.legacy = true;
+			r.row = *itrl;
+		}
+	}
+	return r;
+}
+
+
+/*
+* Open NFT offer of an asset made to `recipient`.
+*/
+SimpleAssets::rowref<SimpleAssets::soffer> SimpleAssets::findOfferTo( name recipient, uint64_t assetid ) {
+	rowref<soffer> r;
+
+	offersto offerto(_self, recipient.value);
+	auto itr = offerto.find( assetid );
+	if ( itr != offerto.end() ) {
+		r.found = true;
+		r.row = *itr;
+	} else if ( hasLegacy() ) {
+		offers offert(_self, _self.value);
+		auto itrl = offert.find( assetid );
+		if ( itrl != offert.end() ) {
+			r.found = r.legacy = true;
+			r.row = *itrl;
+		}
+	}
+	return r;
+}
+
+
+void SimpleAssets::addOffer( name payer, const soffer& o ) {
+	offersown offero(_self, o.owner.value);
+	offero.emplace( payer, [&]( auto& s ) { s = o; });
+
+	offersto offerto(_self, o.offeredto.value);
+	offerto.emplace( payer, [&]( auto& s ) { s = o; });
+	countRows( "offers"_n, 1, 2 * rowBytes( o ) );
+}
+
+
+void SimpleAssets::eraseOffer( const rowref<soffer>& r ) {
+	countRows( "offers"_n, -1, -2 * rowBytes( r.row ) );
+	if ( r.legacy ) {
+		offers offert(_self, _self.value);
+		offert.erase( offert.find( r.row.assetid ) );
+		return;
+	}
+
+	offersown offero(_self, r.row.owner.value);
+	offero.erase( offero.find( r.row.assetid ) );
+
+	offersto offerto(_self, r.row.offeredto.value);
+	offerto.erase( offerto.find( r.row.assetid ) );
+}
+
+
+/*
+* Open FT offer made by `owner`.
+*/
+SimpleAssets::rowref<SimpleAssets::sofferf> SimpleAssets::findOfferf( name owner, uint64_t id ) {
+	rowref<sofferf> r;
+
+	offerfsown offero(_self, owner.value);
+	auto itr = offero.find( id );
+	if ( itr != offero.end() ) {
+		r.found = true;
+		r.row = *itr;
+	} else if ( hasLegacy() ) {
+		offerfs offert(_self, _self.value);
+		auto itrl = offert.find( id );
+		if ( itrl != offert.end() ) {
+			r.found = r.legacy = true;
+			r.row = *itrl;
+		}
+	}
+	return r;
+}
+
+
+/*
+* Open FT offer made to `recipient`.
+*/
+SimpleAssets::rowref<SimpleAssets::sofferf> SimpleAssets::findOfferfTo( name recipient, uint64_t id ) {
+	rowref<sofferf> r;
+
+	offerfsto offerto(_self, recipient.value);
+	auto itr = offerto.find( id );
+	if ( itr != offerto.end() ) {
+		r.found = true;
+		r.row = *itr;
+	} else if ( hasLegacy() ) {
+		offerfs offert(_self, _self.value);
+		auto itrl = offert.find( id );
+		if ( itrl != offert.end() ) {
+			r.found = r.legacy = true;
+			r.row = *itrl;
+		}
+	}
+	return r;
+}
+
+
+void SimpleAssets::addOfferf( name payer, const sofferf& o ) {
+	offerfsown offero(_self, o.owner.value);
+	offero.emplace( payer, [&]( auto& s ) { s = o; });
+
+	offerfsto offerto(_self, o.offeredto.value);
+	offerto.emplace( payer, [&]( auto& s ) { s = o; });
+	countRows( "offerfs"_n, 1, 2 * rowBytes( o ) );
+}
+
+
+void SimpleAssets::eraseOfferf( const rowref<sofferf>& r ) {
+	countRows( "offerfs"_n, -1, -2 * rowBytes( r.row ) );
+	if ( r.legacy ) {
+		offerfs offert(_self, _self.value);
+		offert.erase( offert.find( r.row.id ) );
+		return;
+	}
+
+	offerfsown offero(_self, r.row.owner.value);
+	offero.erase( offero.find( r.row.id ) );
+
+	offerfsto offerto(_self, r.row.offeredto.value);
+	offerto.erase( offerto.find( r.row.id ) );
+}
+
+
+/*
+* True if `owner` has an open FT offer of author/sym (to `offeredto`, or to anyone if empty).
+*/
+bool SimpleAssets::hasOfferf( name owner, name author, symbol sym, name offeredto ) {
+	auto match = [&]( const sofferf& o ) {
+		return o.author == author && o.quantity.symbol == sym && ( !offeredto || o.offeredto == offeredto );
+	};
+
+	offerfsown offero(_self, owner.value);
+	for ( const auto& o : offero ) {
+		if ( match( o ) )
+			return true;
+	}
+
+	if ( hasLegacy() ) {
+		offerfs offert(_self, _self.value);
+		auto owner_index = offert.template get_index<"owner"_n>();
+		for ( auto itro = owner_index.find( owner.value ); itro != owner_index.end() && itro->owner == owner; itro++ ) {
+			if ( match( *itro ) )
+				return true;
+		}
+	}
+	return false;
+}
+
+
+/*
+* Delegation of an asset held by `holder` (the delegatedto account).
+*/
+SimpleAssets::rowref<SimpleAssets::sdelegate> SimpleAssets::findDelegate( name holder, uint64_t assetid ) {
+	rowref<sdelegate> r;
+
+	delegatesto delegateto(_self, holder.value);
+	auto itr = delegateto.find( assetid );
+	if ( itr != delegateto.end() ) {
+		r.found = true;
+		r.row = *itr;
+	} else if ( hasLegacy() ) {
+		delegates delegatet(_self, _self.value);
+		auto itrl = delegatet.find( assetid );
+		if ( itrl != delegatet.end() ) {
+			r.found = r.legacy = true;
+			r.row = *itrl;
+		}
+	}
+	return r;
+}
+
+
+bool SimpleAssets::expired( const sdelegate& d ) {
+	return d.cdate + d.period < now();
+}
+
+
+/*
+* Returns a borrowed asset to its owner and erases the delegation, e.g. once it has expired.
+*/
+void SimpleAssets::reclaimAsset( sassets& assets_f, const batchitem& b, name payer ) {
+	name owner = b.delegate.row.owner;
+	sassets assets_o( _self, owner.value );
+
+	eraseDelegate( b.delegate );
+	moveAsset( assets_f, b.itr, assets_o, owner, payer );
+	merkleSet( b.id, owner );
+}
+
+
+/*
+* Approval of an operator of `owner` who signed the current action. Scans `owner`'s approvals,
+* once per action, usually only a few rows.
+*/
+SimpleAssets::rowref<SimpleAssets::sapproval> SimpleAssets::findOperator( name owner ) {
+	rowref<sapproval> r;
+
+	approvals approvals_(_self, owner.value);
+	for ( const auto& a : approvals_ ) {
+		if ( has_auth( a.op ) ) {
+			r.found = true;
+			r.row = a;
+			break;
+		}
+	}
+	return r;
+}
+
+
+bool SimpleAssets::approves( const sapproval& a, name author ) {
+	return a.authors.empty() || std::find( a.authors.begin(), a.authors.end(), author ) != a.authors.end();
+}
+
+
+/*
+* True if transferall / burnall should leave the asset where it is: other author or category
+* than asked for, or an open offer or delegation.
+*/
+bool SimpleAssets::bulkSkip( name holder, const sasset& a, name author, name category ) {
+	if ( ( author && a.author != author ) || ( category && a.category != category ) )
+		return true;
+
+	return findOffer( holder, a.id ).found || findDelegate( holder, a.id ).found;
+}
+
+
+/*
+* Moves an asset row to the scope of `owner`. The cached source row is destroyed by the
+* erase, so its strings and containers are moved instead of copied. Returns the next row.
+*/
+SimpleAssets::sassets::const_iterator SimpleAssets::moveAsset( sassets& from_t, sassets::const_iterator itr, sassets& to_t, name owner, name payer ) {
+	auto& row = const_cast<sasset&>( *itr );
+	to_t.emplace( payer, [&]( auto& s ) {
+		s = std::move( row );
+		s.owner = owner;
+	});
+	return from_t.erase( itr );
+}
+
+
+
+/*
+* Batch engine of transfer, burn, offer, canceloffer, delegate, undelegate and attach.
+* Ids are sorted and deduplicated first. For every asset the engine then reads, at most once:
+*   Policy::row              - the asset row in assets_f, which must exist (Policy::notfound)
+*   Policy::offer / delegate - the open offer / delegation of the asset held by p.holder;
+*                              lookup::absent checks there is none (Policy::offered / delegated),
+*                              lookup::load hands the row to the policy
+* (Policy::lazy - an id of a drop of p.holder is created first, see materialize;
+*  Policy::expire - an asset whose delegation has expired goes back to its owner and is
+*  skipped by the policy if p.reclaimer names the account paying for the returned row (the
+*  owner of the delegation if signed, else the holder's signer); p.reclaimer checks the
+*  signer itself, validate is not called for these assets)
+* and calls p.validate, then p.apply; p.finish runs once after the last asset, followed by the
+* ownership commitment update. Assets are
+* grouped by author in a flat vector, p.event is called once per author.
+*/
+template<typename Policy>
+void SimpleAssets::batch( Policy& p, sassets& assets_f, std::vector<uint64_t>& assetids ) {
+	if ( !std::is_sorted( assetids.begin(), assetids.end() ) )
+		std::sort( assetids.begin(), assetids.end() );
+	assetids.erase( std::unique( assetids.begin(), assetids.end() ), assetids.end() );
+
+	saarena::vector< std::pair<name, uint64_t> > byauthor;
+	if constexpr ( Policy::events )
+		byauthor.reserve( assetids.size() );
+
+	saarena::vector< std::tuple<name, name, uint64_t> > returned;		// owner, author, assetid
+
+	batchitem b;
+	for ( uint64_t id : assetids ) {
+		b.id = id;
+
+		if constexpr ( Policy::row ) {
+			b.itr = assets_f.find( id );
+			if constexpr ( Policy::lazy ) {
+				if ( b.itr == assets_f.end() )
+					b.itr = materialize( assets_f, p.holder, id, p.rampayer );
+			}
+			check( b.itr != assets_f.end(), Policy::notfound );
+		}
+
+		if constexpr ( Policy::offer != lookup::skip ) {
+			b.offer = findOffer( p.holder, id );
+			if constexpr ( Policy::offer == lookup::absent )
+				check( !b.offer.found, Policy::offered );
+		}
+
+		if constexpr ( Policy::delegate != lookup::skip ) {
+			b.delegate = findDelegate( p.holder, id );
+			if constexpr ( Policy::expire ) {
+				name payer;
+				if ( b.delegate.found && expired( b.delegate.row ) && ( payer = p.reclaimer( b ) ) ) {
+					returned.emplace_back( b.delegate.row.owner, b.itr->author, id );
+					reclaimAsset( assets_f, b, payer );
+					continue;
+				}
+			}
+			if constexpr ( Policy::delegate == lookup::absent )
+				check( !b.delegate.found, Policy::delegated );
+		}
+
+		p.validate( b );
+
+		//Events
+		if constexpr ( Policy::events )
+			byauthor.emplace_back( b.itr->author, id );
+
+		p.apply( assets_f, b );
+	}
+	p.finish( assets_f );
+	merkleCommit();
+
+	if constexpr ( Policy::events ) {
+		// ids are sorted, so sorting the pairs keeps them sorted within each author
+		std::sort( byauthor.begin(), byauthor.end() );
+
+		saarena::vector<uint64_t> ids;
+		for ( size_t i = 0; i < byauthor.size(); ) {
+			name author = byauthor[i].first;
+			ids.clear();
+			for ( ; i < byauthor.size() && byauthor[i].first == author; ++i )
+				ids.push_back( byauthor[i].second );
+			p.event( author, ids );
+		}
+	}
+
+	if constexpr ( Policy::expire ) {
+		std::sort( returned.begin(), returned.end() );
+
+		saarena::vector<uint64_t> ids;
+		for ( size_t i = 0; i < returned.size(); ) {
+			name owner = std::get<0>( returned[i] ), author = std::get<1>( returned[i] );
+			ids.clear();
+			for ( ; i < returned.size() && std::get<0>( returned[i] ) == owner && std::get<1>( returned[i] ) == author; ++i )
+				ids.push_back( std::get<2>( returned[i] ) );
+
+			logEvent( "saetransfer"_n, author, p.holder, owner, ids );
+			if ( deferEvents() )
+				sendEvent(author, p.rampayer, "saetransfer"_n, std::make_tuple(p.holder, owner, ids, string("delegation expired")) );
+		}
+	}
+}
+
+
+/*
+* Creates the sassets row of drop edition `assetid` held by `owner` if it was not created yet.
+* Returns assets_f.end() if the id is not part of a drop of `owner` or was created before (and
+* moved, burned or attached since). An empty `payer` charges the row to the drop's author. The
+* dropbits row of the edition's chunk is created with its first edition, paid the same way, and
+* erased with its last one. The drop row does not change size, so it stays paid by the author;
+* it is erased with the last edition.
+*/
+SimpleAssets::sassets::const_iterator SimpleAssets::materialize( sassets& assets_f, name owner, uint64_t assetid, name payer ) {
+	drops drops_(_self, owner.value);
+	auto d = drops_.lower_bound( assetid );
+	if ( d == drops_.end() || d->first > assetid )
+		return assets_f.end();
+
+	uint64_t chunk = ( assetid - d->first ) / dropchunk;
+	if ( d->done[chunk / 8] >> ( chunk % 8 ) & 1 )
+		return assets_f.end();
+
+	uint64_t base = d->first + chunk * dropchunk;
+	uint64_t bit = assetid - base;
+	dropbits bits_(_self, owner.value);
+	auto c = bits_.find( base );
+	if ( c != bits_.end() && c->taken[bit / 8] >> ( bit % 8 ) & 1 )
+		return assets_f.end();
+
+	if ( !payer )
+		payer = d->author;
+
+	auto itr = assets_f.emplace( payer, [&]( auto& s ) {
+		s.id = assetid;
+		s.owner = owner;
+		s.author = d->author;
+		s.category = d->category;
+		s.idata = d->idata;
+		s.mdata = d->mdata;
+	});
+	countRows( "sassets"_n, 1, rowBytes( *itr ) );
+	merkleSet( assetid, owner );
+
+	uint64_t size = std::min( dropchunk, d->last - base + 1 );		// editions in the chunk
+	bool complete = c != bits_.end() ? c->left == 1 : size == 1;
+	if ( complete ) {
+		if ( c != bits_.end() )
+			bits_.erase( c );
+	} else if ( c == bits_.end() ) {
+		bits_.emplace( payer, [&]( auto& r ) {
+			r.base = base;
+			r.left = size - 1;
+			r.taken.resize( ( size + 7 ) / 8 );
+			r.taken[bit / 8] |= uint8_t( 1 << ( bit % 8 ) );
+		});
+	} else {
+		bits_.modify( c, same_payer, [&]( auto& r ) {
+			r.taken[bit / 8] |= uint8_t( 1 << ( bit % 8 ) );
+			r.left--;
+		});
+	}
+
+	if ( d->left == 1 ) {
+		drops_.erase( d );
+	} else {
+		drops_.modify( d, same_payer, [&]( auto& r ) {
+			if ( complete )
+				r.done[chunk / 8] |= uint8_t( 1 << ( chunk % 8 ) );
+			r.left--;
+		});
+	}
+	return itr;
+}
+
+
+void SimpleAssets::addDelegate( name payer, const sdelegate& d ) {
+	delegatesto delegateto(_self, d.delegatedto.value);
+	delegateto.emplace( payer, [&]( auto& s ) { s = d; });
+	countRows( "delegates"_n, 1, rowBytes( d ) );
+}
+
+
+void SimpleAssets::eraseDelegate( const rowref<sdelegate>& r ) {
+	countRows( "delegates"_n, -1, -rowBytes( r.row ) );
+	if ( r.legacy ) {
+		delegates delegatet(_self, _self.value);
+		delegatet.erase( delegatet.find( r.row.assetid ) );
+		return;
+	}
+
+	delegatesto delegateto(_self, r.row.delegatedto.value);
+	delegateto.erase( delegateto.find( r.row.assetid ) );
+}
+
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+/*
+* Ownership commitment. merkleSet only records the new leaf; merkleCommit rewrites the
+* changed paths once per action, level by level, so paths shared by the assets of one
+* action are written once.
+*/
+bool SimpleAssets::merkleOn() {
+	if ( !_mloaded ) {
+		merkleconf config(_self, _self.value);
+		_mstate = config.exists() ? config.get() : smerkle{};
+		_mloaded = true;
+		SA_COUNT( finds );
+	}
+	return _mstate.enabled;
+}
+
+
+// owner empty - asset left the sassets tables (burned or attached)
+void SimpleAssets::merkleSet( uint64_t assetid, name owner ) {
+	if ( !merkleOn() )
+		return;
+
+	checksum256 leaf;
+	if ( owner ) {
+		uint64_t data[2] = { assetid, owner.value };
+		leaf = sha256( (const char*)data, sizeof(data) );
+	}
+	_mleaves[assetid] = leaf;
+}
+
+
+void SimpleAssets::merkleCommit() {
+	if ( _mleaves.empty() )
+		return;
+
+	const checksum256 zero;
+	saarena::map< uint64_t, checksum256 > cur, next;
+	cur.swap( _mleaves );
+
+	for( int level = 63; level >= 0; --level ) {
+		mnodes nodes( _self, level );
+		next.clear();
+
+		for( auto it = cur.begin(); it != cur.end(); ) {
+			uint64_t prefix = it->first >> 1;
+			auto n = nodes.find( prefix );
+
+			checksum256 left = n != nodes.end() ? n->left : zero;
+			checksum256 right = n != nodes.end() ? n->right : zero;
+			for( ; it != cur.end() && ( it->first >> 1 ) == prefix; ++it )
+				( it->first & 1 ? right : left ) = it->second;
+
+			bool empty = left == zero && right == zero;
+			if ( n == nodes.end() ) {
+				if ( !empty ) {
+					nodes.emplace( _self, [&]( auto& s ) {
+						s.prefix = prefix;
+						s.left = left;
+						s.right = right;
+					});
+				}
+			} else if ( empty ) {
+				nodes.erase( n );
+			} else {
+				nodes.modify( n, same_payer, [&]( auto& s ) {
+					s.left = left;
+					s.right = right;
+				});
+			}
+
+			if ( empty ) {
+				next[prefix] = zero;
+			} else {
+				auto l = left.extract_as_byte_array();
+				auto r = right.extract_as_byte_array();
+				char data[64];
+				memcpy( data, l.data(), 32 );
+				memcpy( data + 32, r.data(), 32 );
+				next[prefix] = sha256( data, sizeof(data) );
+			}
+		}
+		cur.swap( next );
+	}
+
+	_mstate.root = cur[0];
+	merkleconf config(_self, _self.value);
+	config.set(_mstate, _self);
+	SA_COUNT( updates );
+}
+
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+/*
+* Table size counters. Changes are collected during the action and written once per table
+* from the destructor.
+*/
+void SimpleAssets::countRows( name table, int64_t rows, int64_t bytes ) {
+	auto& d = _tsdelta[table];
+	d.rows += rows;
+	d.bytes += bytes;
+}
+
+
+void SimpleAssets::flushStats() {
+	tablestats stats_(_self, _self.value);
+	for ( const auto& d : _tsdelta ) {
+		if ( d.second.rows == 0 && d.second.bytes == 0 )
+			continue;
+
+		auto itr = stats_.find( d.first.value );
+		if ( itr == stats_.end() ) {
+			stats_.emplace( _self, [&]( auto& s ) {
+				s.table = d.first;
+				s.rows = d.second.rows;
+				s.bytes = d.second.bytes;
+			});
+		} else {
+			stats_.modify( itr, same_payer, [&]( auto& s ) {
+				s.rows += d.second.rows;
+				s.bytes += d.second.bytes;
+			});
+		}
+	}
+	_tsdelta.clear();
+}
+
+
+SimpleAssets::~SimpleAssets() {
+	flushStats();
+	flushEvents();
+#ifdef SA_INSTRUMENT
+	sainstrument::stats().print();
+#endif
+	saarena::instance().reset();
 }
 
 
 
 //------------------------------------------------------------------------------------------------------------   
 
-EOSIO_DISPATCH( SimpleAssets, 	(create)(createlog)(transfer)(burn)(update)
-								(offer)(canceloffer)(claim)
+EOSIO_DISPATCH( SimpleAssets, 	(create)(createlog)(createlogh)(createdrop)(droplog)(transfer)(burn)(update)
+								(offer)(canceloffer)(claim)(transferall)(burnall)(bulklog)
 								(regauthor)(authorupdate)
 								(delegate)(undelegate)(attach)(detach)
+								(transferr)(burnr)(offerr)(cancelofferr)(claimr)(delegater)(undelegater)
+								(approve)(revoke)(reclaim)
 								(createf)(updatef)(issuef)(transferf)(burnf)
-								(offerf)(cancelofferf)(claimf)
-								(attachf)(detachf)(openf)(closef)
-								(updatever))
+								(offerf)(offerfbatch)(cancelofferf)(claimf)
+								(attachf)(detachf)(attachfs)(detachfs)(openf)(closef)
+								(setshards)(consolidate)(setreclaim)(sweepf)
+								(updatever)(setevents)(migrate)
+								(setmerkle)(merklesync)(setstats))
 
 //============================================================================================================
 //=======================================- SimpleAssets.io -==================================================
@@ -0,0 +1,272 @@
+#! /bin/bash
+###########################################################################################
+###########################################################################################
+##
+##  SimpleAssets (Digital Assets)
+##  (C) 2019 by CryptoLions [ https://CryptoLions.io ]
+##
+##  Load generator and action replay benchmark for a local single-node test chain.
+##
+##  Usage:
+##    ./tools/loadgen.sh setup                 - create test accounts, register author, create FT
+##    ./tools/loadgen.sh run    [COUNT]        - push COUNT random actions (default 10000)
+##    ./tools/loadgen.sh replay LOGFILE        - push actions recorded in LOGFILE again
+##    ./tools/loadgen.sh report [CSVFILE]      - per action type cpu / net / ram summary
+##    ./tools/loadgen.sh calibrate [ROUNDS]    - batch cost samples for sabatch (default 200)
+##
+##  Every pushed action is appended to $OUT/actions.log (replayable) and measured into
+##  $OUT/stats.csv:  action,cpu_us,net_bytes,ram_bytes,assets
+##    cpu_us    - billed CPU of the transaction (one action per transaction);
+##    net_bytes - billed NET of the transaction;
+##    ram_bytes - net RAM billed by the transaction, the sum of account_ram_deltas of all its
+##                actions, i.e. of every account that paid for or got back a row;
+##    assets    - number of assets created so far, to plot costs against table size.
+##
+##  calibrate pushes transfer / burn / offer / claim / delegate batches of varying size, payload,
+##  nesting and author count and writes $OUT/calib.csv:
+##    action,cpu_us,net_bytes,assets,payload_bytes,nested,authors,ram_bytes
+##    payload_bytes - idata + mdata bytes of all assets in the batch, nested ones included;
+##    nested        - number of assets held in containers of the batch assets;
+##    authors       - number of distinct authors in the batch;
+##    ram_bytes     - RAM billed by the transaction, as in stats.csv.
+##
+##  Requirements: cleos, jq, an unlocked wallet with the key $PUBKEY, and the contract
+##  deployed to $CONTRACT on the chain behind $URL. Run several instances with different
+##  ACCOUNT_OFFSET values to increase load; each instance only touches its own accounts.
+##
+###########################################################################################
+###########################################################################################
+
+URL=${URL:-http://127.0.0.1:8888}
+CLEOS=${CLEOS:-cleos}
+CONTRACT=${CONTRACT:-simpleassets}
+AUTHOR=${AUTHOR:-saloadauthor}
+PUBKEY=${PUBKEY:-EOS6MRyAjQq8ud7hVNYcfnVPJqcVpscN5So8BhtHuGYqET5GDW5CV}
+ACCOUNTS=${ACCOUNTS:-1000}
+ACCOUNT_OFFSET=${ACCOUNT_OFFSET:-0}
+FTSYM=${FTSYM:-LOAD}
+OUT=${OUT:-./loadgen}
+
+# action mix, weights in percent
+MIX_CREATE=${MIX_CREATE:-40}
+MIX_TRANSFER=${MIX_TRANSFER:-25}
+MIX_OFFER=${MIX_OFFER:-10}
+MIX_DELEGATE=${MIX_DELEGATE:-5}
+MIX_TRANSFERF=${MIX_TRANSFERF:-20}
+
+# extra authors used by calibrate, next to $AUTHOR
+CAL_AUTHORS=${CAL_AUTHORS:-"saloadautha2 saloadautha3"}
+
+NAMECHARS="12345abcdefghijklmnopqrstuvwxyz"
+
+RED='\033[0;31m'
+NC='\033[0m'
+
+mkdir -p $OUT
+ACTIONLOG=$OUT/actions.log
+STATS=$OUT/stats.csv
+
+cl() {
+	$CLEOS -u $URL "$@"
+}
+
+# test account name for index $1: "sal" + 6 base-31 name characters
+accname() {
+	local i=$(( $1 + ACCOUNT_OFFSET )) res=""
+	for k in 1 2 3 4 5 6; do
+		res=${NAMECHARS:$(( i % 31 )):1}$res
+		i=$(( i / 31 ))
+	done
+	echo "sal$res"
+}
+
+randacc() {
+	accname $(( (RANDOM * 32768 + RANDOM) % ACCOUNTS ))
+}
+
+# RAM billed by a pushed transaction ($1 - cleos -j output), all payers. Inline actions are
+# nested in inline_traces (nodeos 1.x) or listed in action_traces (2.x), both are walked.
+ramdelta() {
+	jq '[ .processed.action_traces | .. | .account_ram_deltas? // empty | .[].delta ] | add // 0' <<< "$1"
+}
+
+# push one action, measure it and log it.  $1 - action, $2 - json data, $3 - actor
+push() {
+	local res cpu net ram
+	res=$(cl push action -j -f $CONTRACT $1 "$2" -p $3@active 2> /dev/null) || return 1
+
+	cpu=$(jq -r '.processed.receipt.cpu_usage_us' <<< "$res")
+	net=$(( $(jq -r '.processed.receipt.net_usage_words' <<< "$res") * 8 ))
+	ram=$(ramdelta "$res")
+
+	echo "$1	$3	$2" >> $ACTIONLOG
+	echo "$1,$cpu,$net,$ram,$ASSETS" >> $STATS
+	LASTRES=$res
+}
+
+setup() {
+	printf "\t=========== Creating $ACCOUNTS test accounts ===========\n\n"
+	cl create account eosio $AUTHOR $PUBKEY > /dev/null 2>&1
+	for (( i = 0; i < ACCOUNTS; i++ )); do
+		cl create account eosio $(accname $i) $PUBKEY > /dev/null 2>&1 || printf "${RED}failed: $(accname $i)${NC}\n"
+	done
+
+	cl push action $CONTRACT regauthor "[\"$AUTHOR\", \"{\\\"name\\\":\\\"load test\\\"}\", \"\"]" -p $AUTHOR@active > /dev/null
+	cl push action $CONTRACT createf "[\"$AUTHOR\", \"1000000000000 $FTSYM\", 0, \"\"]" -p $AUTHOR@active > /dev/null
+	for (( i = 0; i < ACCOUNTS; i++ )); do
+		cl push action $CONTRACT issuef "[\"$(accname $i)\", \"$AUTHOR\", \"1000000 $FTSYM\", \"\"]" -p $AUTHOR@active > /dev/null
+	done
+}
+
+run() {
+	local count=${1:-10000} r owner to id
+	declare -A OWNERS
+	ASSETS=0
+
+	[ -f $STATS ] || echo "action,cpu_us,net_bytes,ram_bytes,assets" > $STATS
+
+	for (( n = 0; n < count; n++ )); do
+		r=$(( RANDOM % 100 ))
+
+		if (( r < MIX_CREATE || ASSETS == 0 )); then
+			owner=$(randacc)
+			# ~300 bytes of metadata, close to what games and collectibles store
+			push create "[\"$AUTHOR\", \"weapon\", \"$owner\", \"{\\\"name\\\":\\\"Sword $n\\\",\\\"power\\\":$RANDOM,\\\"img\\\":\\\"https://example.com/img/$n.png\\\",\\\"desc\\\":\\\"$(printf '%0200d' 0)\\\"}\", \"{\\\"level\\\":1}\", 0]" $AUTHOR || continue
+			id=$(jq -r '.processed.action_traces[0].inline_traces[] | select(.act.name == "createlogh") | .act.data.assetid' <<< "$LASTRES")
+			OWNERS[$id]=$owner
+			IDS[$ASSETS]=$id
+			ASSETS=$(( ASSETS + 1 ))
+			continue
+		fi
+
+		id=${IDS[$(( (RANDOM * 32768 + RANDOM) % ASSETS ))]}
+		owner=${OWNERS[$id]}
+		to=$(randacc)
+		[ "$owner" == "$to" ] && continue
+		r=$(( r - MIX_CREATE ))
+
+		if (( r < MIX_TRANSFER )); then
+			push transfer "[\"$owner\", \"$to\", [$id], \"load\"]" $owner && OWNERS[$id]=$to
+		elif (( r < MIX_TRANSFER + MIX_OFFER )); then
+			push offer "[\"$owner\", \"$to\", [$id], \"\"]" $owner && \
+			push claim "[\"$to\", [$id]]" $to && OWNERS[$id]=$to
+		elif (( r < MIX_TRANSFER + MIX_OFFER + MIX_DELEGATE )); then
+			# delegated assets are returned by the borrower right away to keep the pool usable
+			push delegate "[\"$owner\", \"$to\", [$id], 0, \"\"]" $owner && \
+			push transfer "[\"$to\", \"$owner\", [$id], \"return\"]" $to
+		else
+			push transferf "[\"$owner\", \"$to\", \"$AUTHOR\", \"1 $FTSYM\", \"load\"]" $owner
+		fi
+	done
+}
+
+replay() {
+	local action actor data
+	ASSETS=0
+
+	[ -f "$1" ] || { printf "${RED}no such log: $1${NC}\n"; exit 1; }
+	ACTIONLOG=$OUT/replay-actions.log
+	STATS=$OUT/replay-stats.csv
+	echo "action,cpu_us,net_bytes,ram_bytes,assets" > $STATS
+
+	while IFS=$'\t' read -r action actor data; do
+		[ "$action" == "create" ] && ASSETS=$(( ASSETS + 1 ))
+		push $action "$data" $actor || printf "${RED}failed: $action $data${NC}\n"
+	done < "$1"
+}
+
+report() {
+	awk -F, 'NR > 1 {
+		n[$1]++; cpu[$1] += $2; net[$1] += $3; ram[$1] += $4; ramall += $4
+		if ($2 > max[$1]) max[$1] = $2
+		assets1 = $5
+
+		# table size buckets: 0-9, 10-99, 100-999, ...
+		b = $5 < 10 ? 0 : 10 ^ int(log($5) / log(10))
+		bn[$1 "," b]++; bcpu[$1 "," b] += $2
+	} END {
+		printf "%-12s %10s %10s %10s %10s %10s\n", "action", "count", "avg cpu", "max cpu", "avg net", "avg ram"
+		for (a in n) printf "%-12s %10d %10.1f %10d %10.1f %10.1f\n", a, n[a], cpu[a] / n[a], max[a], net[a] / n[a], ram[a] / n[a]
+
+		printf "\n%-12s %12s %10s\n", "action", "assets >=", "avg cpu"
+		for (k in bn) { split(k, p, ","); printf "%-12s %12d %10.1f\n", p[1], p[2], bcpu[k] / bn[k] | "sort -k1,1 -k2n" }
+		close("sort -k1,1 -k2n")
+		if (assets1 > 0) printf "\nRAM billed, all payers: %d bytes, %.1f bytes per asset\n", ramall, ramall / assets1
+	}' ${1:-$STATS}
+}
+
+# create one asset with $3 bytes of idata and $4 nested assets for owner $2, by author $1.
+# Sets NEWID, adds to CAL_PAYLOAD.
+calasset() {
+	local res idata="{\\\"d\\\":\\\"$(printf "%0$3d" 0)\\\"}" children=() k
+	res=$(cl push action -j $CONTRACT create "[\"$1\", \"calib\", \"$2\", \"$idata\", \"{}\", 0]" -p $1@active 2> /dev/null) || return 1
+	NEWID=$(jq -r '.processed.action_traces[0].inline_traces[] | select(.act.name == "createlogh") | .act.data.assetid' <<< "$res")
+	CAL_PAYLOAD=$(( CAL_PAYLOAD + $3 + 8 + 2 ))
+
+	for (( k = 0; k < $4; k++ )); do
+		res=$(cl push action -j $CONTRACT create "[\"$1\", \"calib\", \"$2\", \"$idata\", \"{}\", 0]" -p $1@active 2> /dev/null) || return 1
+		children+=($(jq -r '.processed.action_traces[0].inline_traces[] | select(.act.name == "createlogh") | .act.data.assetid' <<< "$res"))
+		CAL_PAYLOAD=$(( CAL_PAYLOAD + $3 + 8 + 2 ))
+	done
+	if (( $4 > 0 )); then
+		cl push action $CONTRACT attach "[\"$2\", $NEWID, [$(IFS=,; echo "${children[*]}")]]" -p $1@active > /dev/null 2>&1 || return 1
+	fi
+}
+
+# push one measured batch action.  $1 - action, $2 - json data, $3 - actor
+calpush() {
+	local res
+	res=$(cl push action -j -f $CONTRACT $1 "$2" -p $3@active 2> /dev/null) || { printf "${RED}failed: $1 ($CAL_N assets)${NC}\n"; return 1; }
+	echo "$1,$(jq -r '.processed.receipt.cpu_usage_us' <<< "$res"),$(( $(jq -r '.processed.receipt.net_usage_words' <<< "$res") * 8 )),$CAL_N,$CAL_PAYLOAD,$CAL_NESTED,$CAL_NAUTHORS,$(ramdelta "$res")" >> $OUT/calib.csv
+}
+
+calibrate() {
+	local rounds=${1:-200} sizes=(1 2 5 10 20 50 100 200) payloads=(16 100 300 1000) authors=($AUTHOR $CAL_AUTHORS)
+	local owner to ids a i action nested payload
+
+	for a in $CAL_AUTHORS; do
+		cl create account eosio $a $PUBKEY > /dev/null 2>&1
+		cl push action $CONTRACT regauthor "[\"$a\", \"{}\", \"\"]" -p $a@active > /dev/null 2>&1
+	done
+	[ -f $OUT/calib.csv ] || echo "action,cpu_us,net_bytes,assets,payload_bytes,nested,authors,ram_bytes" > $OUT/calib.csv
+
+	for (( r = 0; r < rounds; r++ )); do
+		CAL_N=${sizes[$(( RANDOM % ${#sizes[@]} ))]}
+		CAL_NAUTHORS=$(( RANDOM % ${#authors[@]} + 1 ))
+		payload=${payloads[$(( RANDOM % ${#payloads[@]} ))]}
+		nested=$(( RANDOM % 3 ))
+		CAL_PAYLOAD=0
+		CAL_NESTED=0
+		owner=$(randacc)
+		to=$(randacc)
+		[ "$owner" == "$to" ] && continue
+
+		ids=()
+		for (( i = 0; i < CAL_N; i++ )); do
+			calasset ${authors[$(( i % CAL_NAUTHORS ))]} $owner $payload $nested || break
+			ids+=($NEWID)
+			CAL_NESTED=$(( CAL_NESTED + nested ))
+		done
+		(( ${#ids[@]} == CAL_N )) || continue
+		ids=$(IFS=,; echo "${ids[*]}")
+
+		case $(( RANDOM % 4 )) in
+			0)	calpush transfer "[\"$owner\", \"$to\", [$ids], \"calib\"]" $owner ;;
+			1)	calpush offer "[\"$owner\", \"$to\", [$ids], \"\"]" $owner && \
+				calpush claim "[\"$to\", [$ids]]" $to && owner=$to ;;
+			# undelegate needs the period (0) to have passed: a block at least one second later
+			2)	calpush delegate "[\"$owner\", \"$to\", [$ids], 0, \"\"]" $owner && sleep 1.5 && \
+				calpush undelegate "[\"$owner\", \"$to\", [$ids]]" $owner ;;
+		esac
+		calpush burn "[\"$owner\", [$ids], \"\"]" $owner
+	done
+}
+
+case "$1" in
+	setup)	setup ;;
+	run)	run $2 ;;
+	replay)	replay $2 ;;
+	report)	report $2 ;;
+	calibrate)	calibrate $2 ;;
+	*)	sed -n '9,16p' $0 | sed 's/^##//' ; exit 1 ;;
+esac